@@ -18,6 +18,7 @@ PERFORMANCE OF THIS SOFTWARE.
 #define __7SEGMENT_H__
 #include <stdint.h>
 #include <avr/pgmspace.h>
+#include "segment.h"
 
 /* The MAX7219 has built-in BCD-to-7-segment translation, but it is designed
    to be used with common cathode displays. In this case, every digit 
@@ -62,6 +63,11 @@ PERFORMANCE OF THIS SOFTWARE.
     4              6
     2              1
     2              7
+
+  The glyphs themselves are listed in segment.txt, which mksegment.lua turns
+  into a table that is already transposed to this row order. Every glyph is
+  8 row bytes of either 0x00 or 0xff, so drawing a digit is a matter of
+  masking each row with the column bit and ORing it in.
 */
 
 #define DIGIT_1 3
@@ -74,18 +80,10 @@ PERFORMANCE OF THIS SOFTWARE.
 #define DIGIT_RIGHT_LED     7
 #define DIGIT_RIGHTMOST_LED 1
 
-#define SEG_DP 0x10
-#define SEG_a  0x04
-#define SEG_b  0x02
-#define SEG_c  0x08
-#define SEG_d  0x80
-#define SEG_e  0x20
-#define SEG_f  0x01
-#define SEG_g  0x40
-
-#define SEG_LED 0xff
+// Flag ORed into a glyph index to light the decimal point as well
+#define SEGMENT_DP 0x80
 
-// Corresponds to the "Code B" font listed in the MAX7219 datasheet, transposed 
-extern const uint8_t PROGMEM BCDToSegment[16];
+// OR a glyph (from segment.txt) into the row data of the given column
+void Segment_PutGlyph(uint8_t rows[8], uint8_t glyph, uint8_t column);
 
 #endif
@@ -0,0 +1,188 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+#include <avr/pgmspace.h>
+#include "Animation.h"
+#include "Renderer.h"
+#include "Panels.h"
+
+// Progress per frame (8.8 fixed point) for a transition lasting ms milliseconds
+#define STEP(ms) ((uint8_t) ((256UL * 1000 + (uint32_t) (ms) * RENDERER_FPS / 2) / ((uint32_t) (ms) * RENDERER_FPS)))
+
+#define PROGRESS_DONE 0x100
+#define LEVELS 8
+// TRANSITION_FADE blanks the digits this far either side of the midpoint. The
+// MAX7219 is still lit at intensity 0, so swapping them there would show.
+#define FADE_BLANK 0x10
+
+struct TransitionTiming
+{
+  uint8_t step;
+  uint8_t digitOffset[4]; // Start of every digit, in progress units
+};
+
+static const struct TransitionTiming PROGMEM transitionTiming[] =
+{
+  { STEP(400), { 0, 0, 0, 0 } },          // TRANSITION_SCROLL
+  { STEP(320), { 0, 0x30, 0x60, 0x90 } }, // TRANSITION_WIPE
+  { STEP(480), { 0, 0, 0, 0 } },          // TRANSITION_DISSOLVE
+  { STEP(600), { 0, 0, 0, 0 } },          // TRANSITION_FADE
+};
+
+// Ordered (Bayer) dither masks for the dissolve, one per level. The pattern
+// repeats every 4 rows; bit x is column x of the digit.
+static const uint8_t PROGMEM ditherMask[LEVELS + 1][4] =
+{
+  { 0x00, 0x00, 0x00, 0x00 },
+  { 0x01, 0x00, 0x04, 0x00 },
+  { 0x05, 0x00, 0x05, 0x00 },
+  { 0x05, 0x02, 0x05, 0x08 },
+  { 0x05, 0x0a, 0x05, 0x0a },
+  { 0x07, 0x0a, 0x0d, 0x0a },
+  { 0x0f, 0x0a, 0x0f, 0x0a },
+  { 0x0f, 0x0b, 0x0f, 0x0e },
+  { 0x0f, 0x0f, 0x0f, 0x0f },
+};
+
+static uint8_t transition = TRANSITION_SCROLL, animatingDigits = 0, step = 0, fade = 16;
+static uint16_t progress = 0;
+static uint8_t digitLevel[4];
+
+void Animation_Start(const uint8_t newTransition, const uint8_t digits)
+{
+  Animation_Stop();
+  
+  transition = newTransition;
+  animatingDigits = digits & 0xf;
+  progress = 0;
+  step = pgm_read_byte(&transitionTiming[transition].step);
+  
+  for (uint8_t j = 0; j < 4; ++j)
+    digitLevel[j] = 0;
+}
+
+void Animation_Stop()
+{
+  animatingDigits = 0;
+  
+  if (fade != 16)
+  {
+    fade = 16;
+    SetFade(fade);
+  }
+}
+
+bool Animation_Running()
+{
+  return animatingDigits != 0;
+}
+
+uint8_t Animation_Tick()
+{
+  if (!animatingDigits)
+    return 0;
+  
+  uint8_t changed = 0;
+  _Bool done = 1;
+  
+  progress += step;
+  
+  for (uint8_t j = 0, mask = 1; j < 4; ++j, mask <<= 1)
+  {
+    if (!(animatingDigits & mask))
+      continue;
+    
+    uint8_t offset = pgm_read_byte(&transitionTiming[transition].digitOffset[j]);
+    uint16_t p = (progress > offset) ? progress - offset : 0;
+    
+    if (p >= PROGRESS_DONE)
+      p = PROGRESS_DONE;
+    else
+      done = 0;
+    
+    uint8_t level = (p * LEVELS + 0x80) >> 8;
+    
+    if (transition == TRANSITION_FADE)
+    {
+      // Old digit, blank while darkest, new digit
+      if (p < PROGRESS_DONE / 2 - FADE_BLANK)
+        level = 0;
+      else if (p < PROGRESS_DONE / 2 + FADE_BLANK)
+        level = 1;
+      else
+        level = LEVELS;
+    }
+    
+    if (level != digitLevel[j])
+    {
+      digitLevel[j] = level;
+      changed |= mask;
+    }
+  }
+  
+  if (transition == TRANSITION_FADE)
+  {
+    // Brightness goes down to 0 in the first half, and back up to 16 in the
+    // second. The digits are swapped halfway.
+    uint16_t p = (progress >= PROGRESS_DONE) ? PROGRESS_DONE : progress;
+    uint8_t newFade = (p < PROGRESS_DONE / 2) ? 16 - (p >> 3) : (p - PROGRESS_DONE / 2) >> 3;
+    
+    if (newFade != fade)
+    {
+      fade = newFade;
+      SetFade(fade);
+    }
+  }
+  
+  if (done)
+    Animation_Stop();
+  
+  return changed;
+}
+
+uint8_t Animation_DigitRow(const uint8_t digit, const int8_t row, const uint8_t *previousRows, const uint8_t *currentRows)
+{
+  const uint8_t level = animatingDigits ? digitLevel[digit] : LEVELS;
+  
+  switch (transition)
+  {
+    case TRANSITION_SCROLL:
+    {
+      int8_t scrolledRow = row - (LEVELS - level);
+      
+      if (scrolledRow == -1)
+        return 0; // Separator line
+      else if (scrolledRow < -1)
+        return previousRows[scrolledRow + 8]; // wrap around
+      else
+        return currentRows[scrolledRow];
+    }
+    case TRANSITION_WIPE:
+      return (row < level) ? currentRows[row] : previousRows[row];
+    
+    case TRANSITION_DISSOLVE:
+    {
+      uint8_t mask = pgm_read_byte(&ditherMask[level][row & 3]);
+      return (currentRows[row] & mask) | (previousRows[row] & ~mask);
+    }
+    case TRANSITION_FADE:
+      if (level == 0)
+        return previousRows[row];
+      return (level < LEVELS) ? 0 : currentRows[row];
+    
+    default:
+      return (level < LEVELS) ? previousRows[row] : currentRows[row];
+  }
+}
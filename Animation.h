@@ -0,0 +1,54 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+#ifndef __ANIMATION_H__
+#define __ANIMATION_H__
+
+#include <stdbool.h>
+#include <inttypes.h>
+
+/* Timeline for the transitions of the dot matrix digits.
+
+   Progress is kept in 8.8 fixed point, 0x100 being a complete transition.
+   Every digit has its own start offset, so digits can change one after
+   the other. Each frame, the progress of every digit is turned into a level
+   (0 = old digit, 8 = new digit), which selects a precomputed mask or row
+   offset. Rendering a digit row for a frame is then a lookup and a few
+   logic operations, independent of the transition. */
+
+enum enumTransition
+{
+  TRANSITION_SCROLL,   // New digit rolls in from the top
+  TRANSITION_WIPE,     // New digit replaces the old one row by row, digits staggered
+  TRANSITION_DISSOLVE, // New digit appears pixel by pixel (ordered dither)
+  TRANSITION_FADE,     // Dim the display, swap the digits, brighten again
+};
+
+// Start a transition for the given digits (bit 0 = leftmost digit)
+void Animation_Start(const uint8_t transition, const uint8_t digits);
+
+// Abort the running transition, if any
+void Animation_Stop();
+
+bool Animation_Running();
+
+// Advance one frame. Returns the digits whose picture changed.
+uint8_t Animation_Tick();
+
+// Row of a digit in the current frame, combined from the rows of the old and
+// the new digit.
+uint8_t Animation_DigitRow(const uint8_t digit, const int8_t row, const uint8_t *previousRows, const uint8_t *currentRows);
+
+#endif
@@ -73,6 +73,19 @@ uint8_t BCDToBin(uint8_t bcd)
   return bin;
 }
 
+uint8_t BinToBCD(uint8_t bin)
+{
+  uint8_t bcd = 0;
+  while (bin >= 10) {
+    bcd += 0x10;
+    bin -= 10;
+  }
+  
+  bcd += bin;
+  
+  return bcd;
+}
+
 
 void HandleEditUp(const uint8_t editMode, uint8_t *const editDigit, const uint8_t editMaxValue)
 {
@@ -25,6 +25,9 @@ uint8_t BCDSub(uint8_t left, uint8_t right);
 // Converts a BCD-encoded number to binary
 uint8_t BCDToBin(uint8_t bcd);
 
+// Converts a binary number (0-99) to BCD
+uint8_t BinToBCD(uint8_t bin);
+
 #define EDIT_MODE_ONES     0x1
 #define EDIT_MODE_TENS     0x2
 #define EDIT_MODE_MASK     0x03
@@ -18,20 +18,63 @@ PERFORMANCE OF THIS SOFTWARE.
 #include "i2c.h"
 
 #define DS1307_ADDR 0xd0
+#define DS1307_I2C_RETRIES 3 // Holds the time and the settings, try harder
+
+#define DS1307_RESYNC_PERIOD 3600 // seconds
+
+static uint32_t utcTime = 0; // Seconds since 2000, counted from SQW
+static uint16_t sinceSync = DS1307_RESYNC_PERIOD; // seconds
 
 void Read_DS1307_DateTime()
 {
-  // Read the first 7 registers.
+  // Read the first 7 registers. Keep counting on a failure, and retry on the next update.
+  struct DateTime utc;
+  
+  if (Read_I2C_Regs(DS1307_ADDR, 0, 7, (uint8_t *)&utc) == I2C_OK)
+  {
+    utcTime = DateTimeToEpoch(&utc);
+    sinceSync = 0;
+  }
+  
+  EpochToCentralEuropeanTime(utcTime, &TheDateTime);
+}
 
-  Read_I2C_Regs(DS1307_ADDR, 0, 7, (uint8_t *)&TheDateTime);
-  UTCToCentralEuropeanTime(&TheDateTime);
+static void __writeTime()
+{
+  struct DateTime utc;
+  EpochToDateTime(utcTime, &utc);
+  Write_I2C_Regs(DS1307_ADDR, 0,7,(uint8_t *)&utc); // Re-set time and date in same packet to avoid roll-over!
+  sinceSync = DS1307_RESYNC_PERIOD; // The countdown chain was reset
 }
 
 void Write_DS1307_DateTime()
 {
-  struct DateTime utcTime = TheDateTime;
-  CentralEuropeanTimeToUTC(&utcTime);
-  Write_I2C_Regs(DS1307_ADDR, 0,7,(uint8_t *)&utcTime); // Re-set time and date in same packet to avoid roll-over!
+  utcTime = CentralEuropeanTimeToEpoch(&TheDateTime);
+  __writeTime();
+}
+
+void Adjust_DS1307_DateTime(int8_t seconds)
+{
+  utcTime += seconds;
+  __writeTime();
+  EpochToCentralEuropeanTime(utcTime, &TheDateTime);
+}
+
+void Update_DS1307_DateTime(uint8_t seconds)
+{
+  utcTime += seconds;
+  if (sinceSync < DS1307_RESYNC_PERIOD)
+    sinceSync += seconds; // Stays due while reads fail
+  
+  if (sinceSync >= DS1307_RESYNC_PERIOD)
+    Read_DS1307_DateTime();
+  else
+    EpochToCentralEuropeanTime(utcTime, &TheDateTime);
+}
+
+void Invalidate_DS1307_DateTime()
+{
+  sinceSync = DS1307_RESYNC_PERIOD;
 }
 
 // Ensures the DS1307 is correctly configured:
@@ -41,22 +84,31 @@ void Write_DS1307_DateTime()
 
 void Init_DS1307()
 {
+  I2C_SetRetries(DS1307_ADDR, DS1307_I2C_RETRIES);
+  
   // Read the current time (7 registers). Do not use Read_DS1307_DateTime, as it will apply timezone
   Read_I2C_Regs(DS1307_ADDR, 0, 7, (uint8_t *)&TheDateTime); 
   
+  uint8_t control = 0x10; // 1Hz clock
+  
   // See if any of the flags included in the time registers needs changing, as that boils down to
   // re-setting the time.
   if ((TheDateTime.sec & 0x80) || (TheDateTime.hour & 0x40))
   {
     TheDateTime.sec &= ~0x80; // Enable oscillator
     TheDateTime.hour &= ~0x40; // Use 24 hour mode
+    
     // Do not use Write_DS1307_DateTime(), as it will de-apply the timezone..
-    Write_I2C_Regs(DS1307_ADDR, 0,7,(uint8_t *)&TheDateTime); // Re-set time and date in same packet to avoid roll-over!
+    // Re-set time and date in same packet to avoid roll-over, and write the 
+    // control register (which follows them) in the same go.
+    const struct I2C_Buffer buffers[2] = { { (const uint8_t *)&TheDateTime, 7 }, { &control, 1 } };
+    Write_I2C_RegsV(DS1307_ADDR, 0, buffers, 2);
+  }
+  else
+  {
+    // write control register
+    Write_I2C_Regs(DS1307_ADDR, 7,1,&control);
   }
-
-  // write control register
-  uint8_t control = 0x10; // 1Hz clock
-  Write_I2C_Regs(DS1307_ADDR, 7,1,&control);
   
   UTCToCentralEuropeanTime(&TheDateTime);
 }
@@ -70,3 +122,8 @@ void Write_DS1307_RAM(uint8_t *data, uint8_t addr, uint8_t size)
 {
   Write_I2C_Regs(DS1307_ADDR, addr + 8, size, data);
 }
+
+void Write_DS1307_RAMV(const struct I2C_Buffer *buffers, uint8_t count, uint8_t addr)
+{
+  Write_I2C_RegsV(DS1307_ADDR, addr + 8, buffers, count);
+}
@@ -17,12 +17,22 @@ PERFORMANCE OF THIS SOFTWARE.
 #define __DS1307_H__
 
 #include <inttypes.h>
+#include "i2c.h"
 
 void Read_DS1307_DateTime();
 void Write_DS1307_DateTime();
+// Shift the time by a few seconds, both in TheDateTime and the RTC.
+void Adjust_DS1307_DateTime(int8_t seconds);
+// Advance TheDateTime by a number of SQW periods. The RTC is only read once an
+// hour, or after the time was set or invalidated.
+void Update_DS1307_DateTime(uint8_t seconds);
+// TheDateTime was modified; re-read it from the RTC on the next update.
+void Invalidate_DS1307_DateTime();
 void Init_DS1307();
 void Read_DS1307_RAM(uint8_t *data, uint8_t addr, uint8_t size);
 void Write_DS1307_RAM(uint8_t *data, uint8_t addr, uint8_t size);
+// Write several buffers to consecutive RAM addresses, in one transaction.
+void Write_DS1307_RAMV(const struct I2C_Buffer *buffers, uint8_t count, uint8_t addr);
 
 #endif
 
@@ -15,76 +15,272 @@ PERFORMANCE OF THIS SOFTWARE.
 */
 #include "Panels.h"
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 #include <stdlib.h>
 
 
 enum MAX7219_registers
 {
+  MAX7219_NOOP        = 0x00,
   MAX7219_DECODE_MODE = 0x09,
   MAX7219_INTENSITY   = 0x0a,
   MAX7219_SCANLIMIT   = 0x0b,
   MAX7219_SHUTDOWN    = 0x0c,
 };
 
-static uint8_t nrPanels = 0;
+#define NR_CONTROL_REGISTERS 4 // DECODE_MODE through SHUTDOWN
+
+// Re-send the control registers at most once every RESYNC_HOLDOFF calls to Panels_Resync()
+#define RESYNC_HOLDOFF 1250 // ~1 minute when called every CLOCK_TICK
+
 static uint8_t brightness = 4;
+static uint8_t fade = 16; // Scales the brightness, 16 = unchanged
+
+// Last value written to each control register of each panel.
+static uint8_t controlShadow[PANEL_COUNT][NR_CONTROL_REGISTERS];
+static uint16_t resyncHoldoff = RESYNC_HOLDOFF;
+
+// Bit x is set if the shift register of panel x holds a no-op. Clocking in
+// fewer bytes than the length of the chain shifts the previous contents 
+// further down the chain, so this is needed to see if that is harmless.
+static uint8_t noopMask = 0;
+
+// Transmit queue. Data is queued as packets: a length byte, followed by the
+// bytes to be clocked out while slave select is low. The SPI interrupt
+// clocks out the packets back-to-back, and raises slave select (which makes 
+// the MAX7219s latch their shift registers) at the end of every packet. 
+// The queue is large enough to hold a complete frame, plus one control 
+// register write.
+
+#define PACKET_SIZE (1 + 2 * PANEL_COUNT) // Including length
+#define SPI_QUEUE_SIZE ((PANEL_ROWS + 1) * PACKET_SIZE + 1)
+
+static volatile uint8_t spiQueue[SPI_QUEUE_SIZE];
+static volatile uint8_t queueHead = 0; // Only written by the producer
+static volatile uint8_t queueTail = 0; // Only written by the transmitter
+static volatile uint8_t bytesLeft = 0; // Remaining bytes in the packet being clocked out
+static volatile _Bool   spiBusy = 0;
+
+static uint8_t writePos = 0; // Producer position of the packet being built
+
+static inline uint8_t __nextPos(uint8_t pos)
+{
+  return (++pos == SPI_QUEUE_SIZE) ? 0 : pos;
+}
 
-static void MAX7219_WriteAll( uint8_t reg, uint8_t data)
+static inline void __sendNextByte()
 {
+  uint8_t tail = queueTail;
+  SPDR = spiQueue[tail];
+  queueTail = __nextPos(tail);
+  bytesLeft--;
+}
+
+// Start clocking out the packet at the tail of the queue. Must be called 
+// with interrupts disabled, or from the interrupt handler.
+static void __startPacket()
+{
+  uint8_t tail = queueTail;
+  bytesLeft = spiQueue[tail];
+  queueTail = __nextPos(tail);
+  
+  spiBusy = 1;
+  
   // Clear slave select
   PORTB &= ~_BV(PORTB2);
- 
-  // Alternate register and data bits, for every panel
-  for (uint8_t i = 0; i < nrPanels; ++i)
+  __sendNextByte();
+}
+
+static void __transferComplete()
+{
+  if (bytesLeft)
   {
-    SPDR = reg;
-    while (! (SPSR & _BV(SPIF))) ; // Wait for completion
-    SPDR = data;
-    while (! (SPSR & _BV(SPIF))) ; // Wait for completion
+    __sendNextByte();
+    return;
   }
-  // Set slave select
+  
+  // Packet done. Set slave select, so the panels latch the data.
   PORTB |= _BV(PORTB2);
+  
+  if (queueTail != queueHead)
+    __startPacket();
+  else
+    spiBusy = 0;
 }
 
-void InitializePanels(uint8_t numPanels)
+ISR(SPI_STC_vect)
+{
+  __transferComplete();
+}
+
+static uint8_t __queueFree()
+{
+  uint8_t tail = queueTail;
+  uint8_t used = (queueHead >= tail) ? queueHead - tail : queueHead + SPI_QUEUE_SIZE - tail;
+  
+  return SPI_QUEUE_SIZE - 1 - used;
+}
+
+static void __beginPacket(uint8_t length)
+{
+  // Wait until the packet fits. If interrupts are disabled (during startup)
+  // the transmitter has to be driven by hand.
+  while (__queueFree() < length + 1)
+  {
+    if (!(SREG & _BV(SREG_I)) && (SPSR & _BV(SPIF)))
+      __transferComplete();
+  }
+    
+  writePos = queueHead;
+  spiQueue[writePos] = length;
+  writePos = __nextPos(writePos);
+}
+
+static inline void __putByte(uint8_t data)
+{
+  spiQueue[writePos] = data;
+  writePos = __nextPos(writePos);
+}
+
+static void __commitPacket()
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    queueHead = writePos;
+    if (!spiBusy)
+      __startPacket();
+  }
+}
+
+_Bool Panels_Busy()
+{
+  return spiBusy;
+}
+
+// Write a control register on all panels, unless the shadow copy says all
+// panels already have that value.
+static void MAX7219_WriteAll( uint8_t reg, uint8_t data, _Bool force)
+{
+  const uint8_t idx = reg - MAX7219_DECODE_MODE;
+  
+  for (uint8_t i = 0; i < PANEL_COUNT; ++i)
+  {
+    if (controlShadow[i][idx] != data)
+    {
+      controlShadow[i][idx] = data;
+      force = 1;
+    }
+  }
+  
+  if (!force)
+    return; // Nothing changed
+    
+  __beginPacket(2 * PANEL_COUNT);
+  
+  // Alternate register and data bits, for every panel
+  for (uint8_t i = 0; i < PANEL_COUNT; ++i)
+  {
+    __putByte(reg);
+    __putByte(data);
+  }
+  
+  __commitPacket();
+  noopMask = 0;
+}
+
+static uint8_t __intensity()
+{
+  return (brightness * fade) >> 4;
+}
+
+static void __writeControlRegisters(_Bool force)
+{
+  MAX7219_WriteAll( MAX7219_DECODE_MODE, 0, force); // No decode.
+  MAX7219_WriteAll( MAX7219_SCANLIMIT  , 7, force); // Scan all rows
+  MAX7219_WriteAll( MAX7219_SHUTDOWN   , 1, force); // Enable panel
+  MAX7219_WriteAll( MAX7219_INTENSITY, __intensity(), force);
+}
+
+void InitializePanels()
 {
   // Set up SPI outputs
   
   DDRB |= _BV(PORTB2) | _BV(PORTB3) | _BV(PORTB5);
 
-  // Enable SPI, master mode, 1MHz clock
-  SPCR |= _BV(SPE) | _BV(MSTR) | _BV(SPR0);
-
-  nrPanels = numPanels;
+  // Enable SPI, master mode, 1MHz clock, transfer complete interrupt
+  SPCR |= _BV(SPE) | _BV(MSTR) | _BV(SPR0) | _BV(SPIE);
 
-  // Configure panels.
+  // Configure panels. The state of the panels is unknown, so write everything.
+  __writeControlRegisters(1);
+}
 
-  MAX7219_WriteAll( MAX7219_DECODE_MODE, 0); // No decode.
-  MAX7219_WriteAll( MAX7219_SCANLIMIT  , 7); // Scan all rows
-  MAX7219_WriteAll( MAX7219_SHUTDOWN   , 1); // Enable panel
-  MAX7219_WriteAll( MAX7219_INTENSITY, brightness);
+_Bool Panels_Resync()
+{
+  if (resyncHoldoff)
+  {
+    --resyncHoldoff;
+    return 0;
+  }
+  
+  resyncHoldoff = RESYNC_HOLDOFF;
+  __writeControlRegisters(1);
+  
+  return 1;
 }
 
 void SetBrightness(uint8_t level)
 {
   brightness = level;
-  MAX7219_WriteAll( MAX7219_INTENSITY  , level);
+  MAX7219_WriteAll( MAX7219_INTENSITY  , __intensity(), 0);
 }
 
-void SendRow(uint8_t row, const uint8_t *data)
+void SetFade(uint8_t level)
 {
-  // Clear slave select
-  PORTB &= ~_BV(PORTB2);
+  fade = level;
+  MAX7219_WriteAll( MAX7219_INTENSITY  , __intensity(), 0);
+}
 
-  // Panel data is sent in reverse: last byte first.
-  for (int8_t x = nrPanels -1; x >= 0 ; --x)
+void SendRow(uint8_t row, const uint8_t *data, uint8_t panelMask)
+{
+  panelMask &= (1 << PANEL_COUNT) - 1;
+  
+  if (!panelMask)
+    return;
+  
+  // Panel data is sent in reverse: last byte first. Panels beyond the last 
+  // one that needs updating can be left out entirely, but only if the data 
+  // that ends up being shifted into them instead is a no-op.
+  uint8_t chainLength = PANEL_COUNT;
+  
+  while (!(panelMask & (1 << (chainLength - 1))))
+    --chainLength;
+
+  const uint8_t shiftedMask = (1 << (PANEL_COUNT - chainLength)) - 1;
+  
+  if ((noopMask & shiftedMask) != shiftedMask)
+    chainLength = PANEL_COUNT;
+  
+  __beginPacket(2 * chainLength);
+  
+  uint8_t newNoopMask = noopMask << chainLength;
+  
+  for (int8_t x = chainLength - 1; x >= 0 ; --x)
   {
-    SPDR = 8-row;
-    while (! (SPSR & _BV(SPIF))) ; // Wait for completion
-    SPDR = data[x];
-    while (! (SPSR & _BV(SPIF))) ; // Wait for completion
+    if (panelMask & (1 << x))
+    {
+      __putByte(8-row);
+      __putByte(data[x]);
+    }
+    else
+    {
+      // Leave this panel alone
+      __putByte(MAX7219_NOOP);
+      __putByte(0);
+      newNoopMask |= (1 << x);
+    }
   }
-  // Set slave select
-  PORTB |= _BV(PORTB2);
+  
+  __commitPacket();
+  noopMask = newNoopMask;
 }
-
@@ -17,10 +17,40 @@ PERFORMANCE OF THIS SOFTWARE.
 #define __PANELS_H__
 #include <stdint.h>
 
+// Number of MAX7219 modules in the daisy chain. Set from the Makefile (PANELS=n)
+#ifndef PANEL_COUNT
+#define PANEL_COUNT 4
+#endif
+
+#if PANEL_COUNT < 1 || PANEL_COUNT > 8
+#error "PANEL_COUNT must be between 1 and 8"
+#endif
+
+// Every panel is an 8x8 matrix; the frame buffer holds one byte per panel per row.
+#define PANEL_ROWS 8
+#define FRAME_SIZE (PANEL_ROWS * PANEL_COUNT)
+
 extern uint8_t *panelBitMask;
 
-void InitializePanels(uint8_t numPanels);
+// Initialize SPI, and configure all panels. Only needs to be called once,
+// control registers are only sent when their value changes.
+void InitializePanels();
 void SetBrightness(uint8_t level);
-void SendRow(uint8_t row, const uint8_t *data);
+// Dim the panels relative to the brightness, for fading. 16 = no dimming.
+// This dims all panels, and at low brightness there are only a few steps.
+void SetFade(uint8_t level);
+
+// Unconditionally re-send all control registers, to recover panels that 
+// glitched. Rate-limited: this does nothing (and returns false) unless enough 
+// calls have passed since the last resync, so it can be called every tick.
+// Returns true if a resync was done; the pixel data should be re-sent too.
+_Bool Panels_Resync();
+// Send a single row. Bit x of panelMask indicates data[x] needs to be sent, 
+// other panels are skipped.
+void SendRow(uint8_t row, const uint8_t *data, uint8_t panelMask);
+
+// Panel updates are queued, and clocked out by the SPI interrupt. Returns
+// true while there is still data being sent.
+_Bool Panels_Busy();
 
 #endif
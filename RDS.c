@@ -0,0 +1,220 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+#include <string.h>
+#include "RDS.h"
+
+// Streaming decoder for RDS groups 0 (program service name), 2 (RadioText) 
+// and 4A (clock time). Everything is kept in fixed buffers.
+
+// Blocks with more errors than this are ignored
+#ifndef RDS_MAX_ERRORS
+#define RDS_MAX_ERRORS 1 // At most 2 corrected bits
+#endif
+
+#define BLOCK_A 0 // PI code
+#define BLOCK_B 1 // Group type, and a few group specific bits
+#define BLOCK_C 2
+#define BLOCK_D 3
+
+// Block B
+#define GROUP_TYPE(b) ((b) >> 11) // Type and version: 0A = 0, 0B = 1, 2A = 4, ...
+  #define GROUP_0A 0
+  #define GROUP_0B 1
+  #define GROUP_2A 4
+  #define GROUP_2B 5
+  #define GROUP_4A 8
+#define PS_ADDRESS(b) ((b) & 0x03)
+#define RT_ADDRESS(b) ((b) & 0x0f)
+#define RT_AB 0x10 // Toggled when a new RadioText starts
+
+#define RT_SEGMENTS 16
+#define RT_END '\r'
+
+#define MJD_2000 51544UL // Modified Julian Day of 2000-01-01
+#define MJD_2100 88069UL
+
+static uint16_t pi = 0;
+
+// The station name is assembled in psNext, and copied once it is complete, so
+// it never shows half of a changed name.
+static char ps[RDS_PS_LENGTH + 1];
+static char psNext[RDS_PS_LENGTH];
+static uint8_t psSegments = 0; // Bit per 2 characters received in psNext
+
+static char rt[RDS_RT_LENGTH + 1];
+static uint16_t rtSegments = 0; // Bit per segment received
+static uint8_t rtEnd = RT_SEGMENTS; // Segments up to the end marker
+static uint8_t rtAB = 0;
+
+static uint32_t clockTime;
+static _Bool clockTimeValid = 0;
+
+static char __printable(uint8_t c)
+{
+  return (c < 0x20 || c > 0x7e) ? ' ' : c;
+}
+
+static void __clearRadioText()
+{
+  memset(rt, ' ', RDS_RT_LENGTH);
+  rt[RDS_RT_LENGTH] = 0;
+  rtSegments = 0;
+  rtEnd = RT_SEGMENTS;
+}
+
+void RDS_Reset()
+{
+  pi = 0;
+  ps[0] = 0;
+  psSegments = 0;
+  __clearRadioText();
+  clockTimeValid = 0;
+}
+
+static void __stationName(uint8_t address, uint16_t chars)
+{
+  psNext[address * 2] = __printable(chars >> 8);
+  psNext[address * 2 + 1] = __printable(chars & 0xff);
+  psSegments |= 1 << address;
+  
+  if (psSegments == 0x0f)
+  {
+    memcpy(ps, psNext, RDS_PS_LENGTH);
+    ps[RDS_PS_LENGTH] = 0;
+    psSegments = 0;
+  }
+}
+
+// Store one RadioText segment of 2 (version B) or 4 (version A) characters
+static void __radioText(uint8_t address, const uint8_t *chars, uint8_t length)
+{
+  char *dest = rt + address * length;
+  uint8_t end = rtEnd;
+  uint8_t i;
+  
+  for (i = 0; i < length; ++i)
+  {
+    if (chars[i] == RT_END)
+    {
+      dest[i] = 0;
+      end = address + 1;
+      break;
+    }
+    
+    dest[i] = __printable(chars[i]);
+  }
+  
+  // Stations may send a longer text without toggling A/B
+  if (i == length && address + 1 >= end)
+    end = RT_SEGMENTS;
+  
+  // The segment holding the previous end marker, and those after it, belong
+  // to the older text
+  if (end != rtEnd)
+  {
+    if (rtEnd < RT_SEGMENTS)
+      rtSegments &= ~(0xffff << (rtEnd - 1));
+    rtEnd = end;
+  }
+  
+  rtSegments |= 1 << address;
+}
+
+static void __clockTime(uint16_t b, uint16_t c, uint16_t d)
+{
+  uint32_t mjd = ((uint32_t) (b & 0x03) << 15) | (c >> 1);
+  uint8_t hour = ((c & 0x01) << 4) | (d >> 12);
+  uint8_t minute = (d >> 6) & 0x3f;
+  // Bits 0-5 of block D hold the local time offset, which is not needed.
+  
+  if (mjd < MJD_2000 || mjd >= MJD_2100 || hour > 23 || minute > 59)
+    return;
+  
+  clockTime = (mjd - MJD_2000) * 86400UL + hour * 3600UL + minute * 60;
+  clockTimeValid = 1;
+}
+
+void RDS_Decode(const uint16_t *blocks, const uint8_t *errors)
+{
+  if (errors[BLOCK_A] <= RDS_MAX_ERRORS && blocks[BLOCK_A] != pi)
+  {
+    // Another station
+    RDS_Reset();
+    pi = blocks[BLOCK_A];
+  }
+  
+  if (errors[BLOCK_B] > RDS_MAX_ERRORS)
+    return; // Unknown group type
+  
+  const uint16_t b = blocks[BLOCK_B];
+  const _Bool cValid = errors[BLOCK_C] <= RDS_MAX_ERRORS;
+  const _Bool dValid = errors[BLOCK_D] <= RDS_MAX_ERRORS;
+  
+  switch (GROUP_TYPE(b))
+  {
+    case GROUP_0A:
+    case GROUP_0B:
+      if (dValid)
+        __stationName(PS_ADDRESS(b), blocks[BLOCK_D]);
+      break;
+    case GROUP_2A:
+    case GROUP_2B:
+      if ((b & RT_AB) != rtAB)
+      {
+        __clearRadioText();
+        rtAB = b & RT_AB;
+      }
+      
+      if (GROUP_TYPE(b) == GROUP_2A && cValid && dValid)
+      {
+        const uint8_t chars[4] = { blocks[BLOCK_C] >> 8, blocks[BLOCK_C] & 0xff, blocks[BLOCK_D] >> 8, blocks[BLOCK_D] & 0xff };
+        __radioText(RT_ADDRESS(b), chars, 4);
+      }
+      else if (GROUP_TYPE(b) == GROUP_2B && dValid)
+      {
+        const uint8_t chars[2] = { blocks[BLOCK_D] >> 8, blocks[BLOCK_D] & 0xff };
+        __radioText(RT_ADDRESS(b), chars, 2);
+        rt[RT_SEGMENTS * 2] = 0; // Version B carries up to 32 characters
+      }
+      break;
+    case GROUP_4A:
+      if (cValid && dValid)
+        __clockTime(b, blocks[BLOCK_C], blocks[BLOCK_D]);
+      break;
+  }
+}
+
+const char *RDS_GetStationName()
+{
+  return ps[0] ? ps : 0;
+}
+
+const char *RDS_GetRadioText()
+{
+  const uint16_t expected = 0xffff >> (RT_SEGMENTS - rtEnd);
+  
+  return (rtSegments & expected) == expected ? rt : 0;
+}
+
+_Bool RDS_TakeClockTime(uint32_t *epoch)
+{
+  if (!clockTimeValid)
+    return 0;
+  
+  *epoch = clockTime;
+  clockTimeValid = 0;
+  return 1;
+}
@@ -0,0 +1,39 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+#ifndef __RDS_H__
+#define __RDS_H__
+
+#include <inttypes.h>
+
+#define RDS_PS_LENGTH 8
+#define RDS_RT_LENGTH 64
+
+// Decode one RDS group: blocks A - D, with the number of errors of each block
+// as reported by the SI4702 (0 = none, 1 = 1-2 corrected, 2 = 3-5 corrected,
+// 3 = uncorrectable).
+void RDS_Decode(const uint16_t *blocks, const uint8_t *errors);
+// Forget everything received, e.g. after tuning.
+void RDS_Reset();
+
+// Program service name (8 characters), or 0 until all of it was received.
+const char *RDS_GetStationName();
+// RadioText, up to the end marker, or 0 until all of it was received.
+const char *RDS_GetRadioText();
+// Clock time (UTC, seconds since 2000) of the last CT group. Returns 0 if none
+// was received since the previous call.
+_Bool RDS_TakeClockTime(uint32_t *epoch);
+
+#endif
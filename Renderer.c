@@ -20,381 +20,646 @@ PERFORMANCE OF THIS SOFTWARE.
 #include "7Segment.h"
 #include "DateTime.h"
 #include "settings.h"
-#include <string.h>
 #include "SI4702.h"
+#include "Animation.h"
 
-static uint8_t previousHour = 0, previousMinute = 0, animationState = 0, myMainMode = 0, ledState = 0;
+static uint8_t previousHour = 0, previousMinute = 0, myMainMode = 0, ledState = 0;
 
 static uint16_t blinkMask = 0x0;
 
 static uint8_t blinkStatus = 0;
 
-static uint8_t previousContent[ 8 * 4 ];
+static uint8_t previousContent[ FRAME_SIZE ];
 static uint8_t invertionMode = NOT_INVERTED;
+static _Bool forceRedraw = 0;
 
 static const struct AlarmSetting *alarm = 0;
 
-#define BLINK_PERIOD 10
-#define BLINK_SHORT_PERIOD  3
-#define BLINK_LONG_PERIOD 17
+// Unpacked copies of the dot-matrix digits on display (and the ones being
+// rolled away), so rendering a row doesn't have to go through flash.
+struct CachedDigit
+{
+  uint8_t character;
+  uint8_t rows[PANEL_ROWS];
+};
+
+static struct CachedDigit currentDigits[4], previousDigits[4];
+static _Bool mainDigitsValid = 0;
+
+// Dirty tracking. Each layer (main digits, weekday bar, 7-segment digits,
+// LEDs, blink overlay, inversion) marks the panel rows it covers when its
+// content changes. Only those get recomposed and sent. Bit n = row n.
+static uint8_t dirtyRows[ PANEL_COUNT ];
+
+// What the layers looked like when they were last composed
+static uint8_t composedMainMode = 0xff, composedDayKey = 0xff, composedSecondaryMode = 0xff, composedLeds = 0;
+static uint8_t segmentRows[ PANEL_ROWS ]; // 7-segment digits, without the LEDs
+static _Bool mainChanged = 0, secondaryChanged = 0;
+
+// Panel layout. The dot matrix area is MATRIX_PANELS wide, starting at panel
+// MATRIX_PANEL. The (rotated) 7-segment adapter board is at SEGMENT_PANEL. 
+// Any other panels in the chain are left blank.
+#define MATRIX_PANELS 3
+
+#ifndef MATRIX_PANEL
+#define MATRIX_PANEL 0
+#endif
+
+#ifndef SEGMENT_PANEL
+#define SEGMENT_PANEL 3
+#endif
+
+#if MATRIX_PANEL + MATRIX_PANELS > PANEL_COUNT || SEGMENT_PANEL >= PANEL_COUNT
+#error "Panel layout does not fit in PANEL_COUNT panels"
+#endif
+
+#if SEGMENT_PANEL >= MATRIX_PANEL && SEGMENT_PANEL < MATRIX_PANEL + MATRIX_PANELS
+#error "Panel layout: 7-segment panel overlaps the dot matrix"
+#endif
+
+#define ALL_MATRIX_PANELS 0x7
+#define WEEKDAY_PANELS 0x1
+
+// Dot matrix panels (bit 0 = MATRIX_PANEL) covered by each main digit
+static const uint8_t digitPanels[4] = { 0x1, 0x2, 0x6, 0x4 };
+
+// Timing, in render frames
+#define FRAMES(ms) ((uint8_t) (((uint32_t) (ms) * RENDERER_FPS + 500) / 1000))
+
+#define BLINK_PERIOD FRAMES(480)
+#define BLINK_SHORT_PERIOD FRAMES(144)
+#define BLINK_LONG_PERIOD FRAMES(816)
+
+// Transition used when the time changes
+#ifndef RENDERER_TRANSITION
+#define RENDERER_TRANSITION TRANSITION_SCROLL
+#endif
+
+static uint8_t transition = RENDERER_TRANSITION;
+
+#ifdef RENDERER_PROFILE
+#include <avr/io.h>
+
+uint16_t Renderer_MaxFrameTicks = 0;
+#endif
 
 void Renderer_Init()
 {
   for (int i = 0; i < sizeof(previousContent); ++i)
     previousContent[i] = 0;
+  
+  // Panel contents are unknown after power-up
+  Renderer_Redraw();
+  
+  for (uint8_t i = 0; i < 4; ++i)
+    currentDigits[i].character = previousDigits[i].character = 0xff;
 }
 
-void Renderer_SetAlarmStruct( const struct AlarmSetting *pAlarm )
+static void __markMatrix(uint8_t panels, const uint8_t rows)
 {
-  alarm = pAlarm;
+  for (uint8_t j = MATRIX_PANEL; j < MATRIX_PANEL + MATRIX_PANELS; ++j, panels >>= 1)
+  {
+    if (panels & 1)
+      dirtyRows[j] |= rows;
+  }
 }
 
-static uint8_t __getDigitMaskSingle(const uint8_t character, const int8_t row)
+// bit 0 = leftmost digit
+static void __markMainDigits(uint8_t digits)
 {
-  // Two rows per byte, lower nybble first.
-  uint8_t tworow = pgm_read_byte(font +  character * 4 + row/2);
+  uint8_t panels = 0;
+  
+  for (uint8_t j = 0; j < 4; ++j, digits >>= 1)
+  {
+    if (digits & 1)
+      panels |= digitPanels[j];
+  }
+  
+  __markMatrix(panels, 0xff);
+}
 
-  if (row & 1)
+// Mark everything covered by the given flash mask
+static void __markBlinking(const uint16_t mask)
+{
+  uint8_t digits = 0;
+  
+  for (uint8_t j = 0, bit = 0x80; j < 4; ++j, bit >>= 1)
   {
-    return tworow >> 4;
+    if (mask & bit)
+      digits |= 1 << j;
   }
-  else
+  
+  __markMainDigits(digits);
+  
+  if (mask & 0x100)
+    __markMatrix(WEEKDAY_PANELS, 0xff);
+  
+  if (mask & 0x0f)
+    secondaryChanged = 1;
+}
+
+void Renderer_SetAlarmStruct( const struct AlarmSetting *pAlarm )
+{
+  if (alarm != pAlarm)
   {
-    return tworow & 0xf;
+    __markMatrix(ALL_MATRIX_PANELS, 0xff);
+    secondaryChanged = 1;
   }
+  
+  alarm = pAlarm;
 }
 
-static uint8_t __getDigitMask(uint8_t prevDigit, uint8_t currentDigit, int8_t row)
+static _Bool __cacheDigit(struct CachedDigit *digit, const uint8_t character)
 {
-  uint8_t digitToShow = currentDigit;
-  if (currentDigit != prevDigit)
-    row = row - animationState; // use scrolling
- 
-  if (row == -1)
+  if (digit->character == character)
+    return 0;
+  
+  digit->character = character;
+  
+  const uint8_t *f = font + character * 4;
+  
+  for (uint8_t row = 0; row < PANEL_ROWS; row += 2)
   {
-    return 0; // Seperator line
+    // Two rows per byte, lower nybble first.
+    uint8_t tworow = pgm_read_byte(f++);
+    digit->rows[row] = tworow & 0xf;
+    digit->rows[row + 1] = tworow >> 4;
   }
-  else if (row < -1)
+  
+  return 1;
+}
+
+// Returns the digits (bit 0 = leftmost) whose cache entries changed
+static uint8_t __cacheMainDigits(const uint8_t left, const uint8_t right, const uint8_t previousLeft, const uint8_t previousRight)
+{
+  const uint8_t characters[4] = { left >> 4, left & 0xf, right >> 4, right & 0xf };
+  const uint8_t previousCharacters[4] = { previousLeft >> 4, previousLeft & 0xf, previousRight >> 4, previousRight & 0xf };
+  uint8_t changed = 0;
+  
+  for (uint8_t j = 0; j < 4; ++j)
   {
-    // Use prevDigit
-    digitToShow = prevDigit;
-    row = row + 8; // wrap around
+    if (__cacheDigit(currentDigits + j, characters[j]) | __cacheDigit(previousDigits + j, previousCharacters[j]))
+      changed |= 1 << j;
   }
   
-  return __getDigitMaskSingle(digitToShow, row);
+  return changed;
 }
-static void __privateRender(const uint8_t secondaryMode)
+
+static uint8_t __getDigitMask(const uint8_t digit, int8_t row)
 {
-  InitializePanels(4);
+  const struct CachedDigit *current = currentDigits + digit;
+  const struct CachedDigit *previous = previousDigits + digit;
   
-  uint8_t data[4]; // Data to be sent to the panels
+  if (current->character == previous->character)
+    return current->rows[row];
+  
+  // Digit is in transition
+  return Animation_DigitRow(digit, row, previous->rows, current->rows);
+}
 
-  // Pre-compute the data for the 7-segment displays, it needs to be rotated
-  uint8_t segmentDigits[8] = { 0 };
+static _Bool __ledIsLit(const uint8_t thisLedState)
+{
+  return thisLedState == LED_ON || ( thisLedState == LED_BLINK_LONG && (blinkStatus < BLINK_LONG_PERIOD)) || (thisLedState == LED_BLINK_SHORT && (blinkStatus < BLINK_SHORT_PERIOD));
+}
+
+// Columns of the 7-segment panel whose LED is currently lit. An LED is 
+// switched by lighting its entire column.
+static uint8_t __ledColumns()
+{
+  static const uint8_t ledColumn[4] = { DIGIT_LEFTMOST_LED, DIGIT_LEFT_LED, DIGIT_RIGHT_LED, DIGIT_RIGHTMOST_LED };
   uint8_t myLedState = ledState;
-  uint8_t thisLedState = myLedState & 0x03;
-  myLedState >>= 2;
+  uint8_t columns = 0;
   
-  if (thisLedState == LED_ON || ( thisLedState == LED_BLINK_LONG && (blinkStatus < BLINK_LONG_PERIOD)) || (thisLedState == LED_BLINK_SHORT && (blinkStatus < BLINK_SHORT_PERIOD)))
+  for (uint8_t j = 0; j < 4; ++j, myLedState >>= 2)
   {
-    segmentDigits[DIGIT_LEFTMOST_LED] = SEG_LED;
+    if (__ledIsLit(myLedState & 0x03))
+      columns |= 1 << ledColumn[j];
   }
   
-  thisLedState = myLedState & 0x03;
-  myLedState >>= 2;
+  return columns;
+}
+
+static void __updateMainLayer()
+{
+  uint8_t changedDigits = 0, dayKey = 0;
+  
+  mainDigitsValid = 0;
   
-  if (thisLedState == LED_ON || ( thisLedState == LED_BLINK_LONG && (blinkStatus < BLINK_LONG_PERIOD)) || (thisLedState == LED_BLINK_SHORT && (blinkStatus < BLINK_SHORT_PERIOD)))
+  switch(myMainMode)
   {
-    segmentDigits[DIGIT_LEFT_LED] = SEG_LED;
+    case MAIN_MODE_TIME:
+      changedDigits = __cacheMainDigits(TheDateTime.hour, TheDateTime.min, previousHour, previousMinute);
+      dayKey = TheDateTime.wday;
+      mainDigitsValid = 1;
+      break;
+    case MAIN_MODE_DATE:
+      changedDigits = __cacheMainDigits(TheDateTime.day, TheDateTime.month, TheDateTime.day, TheDateTime.month);
+      dayKey = TheDateTime.wday;
+      mainDigitsValid = 1;
+      break;
+    case MAIN_MODE_ALARM:
+      if (alarm)
+      {
+        changedDigits = __cacheMainDigits(alarm->hour, alarm->min, alarm->hour, alarm->min);
+        dayKey = 0x80 | (alarm->flags & ALARM_DAY_BITS);
+        mainDigitsValid = 1;
+      }
+      break;
   }
-
-  thisLedState = myLedState & 0x03;
-  myLedState >>= 2;
   
-  if (thisLedState == LED_ON || ( thisLedState == LED_BLINK_LONG && (blinkStatus < BLINK_LONG_PERIOD)) || (thisLedState == LED_BLINK_SHORT && (blinkStatus < BLINK_SHORT_PERIOD)))
+  if (myMainMode != composedMainMode)
   {
-    segmentDigits[DIGIT_RIGHT_LED] = SEG_LED;
+    composedMainMode = myMainMode;
+    __markMatrix(ALL_MATRIX_PANELS, 0xff);
   }
   
-  thisLedState = myLedState & 0x03;
+  if (dayKey != composedDayKey)
+  {
+    composedDayKey = dayKey;
+    __markMatrix(WEEKDAY_PANELS, 0xff);
+  }
   
-  if (thisLedState == LED_ON || ( thisLedState == LED_BLINK_LONG && (blinkStatus < BLINK_LONG_PERIOD)) || (thisLedState == LED_BLINK_SHORT && (blinkStatus < BLINK_SHORT_PERIOD)))
+  __markMainDigits(changedDigits);
+}
+
+static void __updateSegmentLayer(const uint8_t secondaryMode)
+{
+  if (secondaryMode != composedSecondaryMode)
   {
-    segmentDigits[DIGIT_RIGHTMOST_LED] = SEG_LED;
+    composedSecondaryMode = secondaryMode;
+    secondaryChanged = 1;
   }
   
-  switch (secondaryMode)
+  if (secondaryChanged)
   {
-    case SECONDARY_MODE_SEC:
-      segmentDigits[DIGIT_2] = pgm_read_byte(BCDToSegment + (TheDateTime.sec >> 4));
-      segmentDigits[DIGIT_3] = pgm_read_byte(BCDToSegment + (TheDateTime.sec & 0xf));
-      break;
-    case SECONDARY_MODE_YEAR:
-      segmentDigits[DIGIT_1] = pgm_read_byte(BCDToSegment + 2);
-      segmentDigits[DIGIT_2] = pgm_read_byte(BCDToSegment + 0);
-      segmentDigits[DIGIT_3] = pgm_read_byte(BCDToSegment + (TheDateTime.year >> 4));
-      segmentDigits[DIGIT_4] = pgm_read_byte(BCDToSegment + (TheDateTime.year & 0xf));
-      break;
+    // Glyphs for the 7-segment displays, left to right
+    uint8_t segmentGlyph[4] = { GLYPH_BLANK, GLYPH_BLANK, GLYPH_BLANK, GLYPH_BLANK };
+    uint8_t rows[PANEL_ROWS] = { 0 };
     
-    case SECONDARY_MODE_VOLUME:
-    {
-      uint8_t vol = SI4702_GetVolume();
-      segmentDigits[DIGIT_4] = SEG_d;
-      segmentDigits[DIGIT_3] = pgm_read_byte(BCDToSegment + (vol%10));
-      segmentDigits[DIGIT_2] = pgm_read_byte(BCDToSegment + (vol/10));
-      segmentDigits[DIGIT_1] = SEG_d;
-      break;
-    }
-    case SECONDARY_MODE_ALARM:
+    secondaryChanged = 0;
+    
+    // Digits 0-9 map directly onto GLYPH_0 .. GLYPH_9
+    switch (secondaryMode)
     {
-      if (!alarm || (alarm->flags & ALARM_SUSPENDED))
+      case SECONDARY_MODE_SEC:
+        segmentGlyph[1] = TheDateTime.sec >> 4;
+        segmentGlyph[2] = TheDateTime.sec & 0xf;
+        break;
+      case SECONDARY_MODE_YEAR:
+        segmentGlyph[0] = GLYPH_2;
+        segmentGlyph[1] = GLYPH_0;
+        segmentGlyph[2] = TheDateTime.year >> 4;
+        segmentGlyph[3] = TheDateTime.year & 0xf;
+        break;
+    
+      case SECONDARY_MODE_VOLUME:
       {
-        // Horizontal dashes
-        segmentDigits[DIGIT_1] = segmentDigits[DIGIT_2] = segmentDigits[DIGIT_3] = segmentDigits[DIGIT_4] = SEG_g;
+        uint8_t vol = SI4702_GetVolume();
+        segmentGlyph[3] = GLYPH_UNDERSCORE;
+        segmentGlyph[2] = vol % 10;
+        segmentGlyph[1] = vol / 10;
+        segmentGlyph[0] = GLYPH_UNDERSCORE;
         break;
       }
+      case SECONDARY_MODE_ALARM:
+      {
+        if (!alarm || (alarm->flags & ALARM_SUSPENDED))
+        {
+          // Horizontal dashes
+          segmentGlyph[0] = segmentGlyph[1] = segmentGlyph[2] = segmentGlyph[3] = GLYPH_DASH;
+          break;
+        }
       
-      if ( !(alarm->flags & ALARM_TYPE_RADIO))
+        if ( !(alarm->flags & ALARM_TYPE_RADIO))
+        {
+          segmentGlyph[0] = GLYPH_b;
+          segmentGlyph[1] = GLYPH_E;
+          segmentGlyph[2] = GLYPH_E;
+          segmentGlyph[3] = GLYPH_P;
+          break;
+        }
+        // fall-through
+      }
+      case SECONDARY_MODE_RADIO:
       {
-        segmentDigits[DIGIT_1] = SEG_f | SEG_g | SEG_e | SEG_c | SEG_d; // lowercase b
-        segmentDigits[DIGIT_2] = SEG_a | SEG_f | SEG_g | SEG_e | SEG_d; // Uppercase E
-        segmentDigits[DIGIT_3] = SEG_a | SEG_f | SEG_g | SEG_e | SEG_d; // Uppercase E
-        segmentDigits[DIGIT_4] = SEG_a | SEG_f | SEG_b | SEG_g | SEG_e; // lowecase p
+        if (SI4702_GetState() == SI4702_STARTING)
+        {
+          // Horizontal dashes until the radio is up
+          segmentGlyph[0] = segmentGlyph[1] = segmentGlyph[2] = segmentGlyph[3] = GLYPH_DASH;
+          break;
+        }
+        
+        uint16_t freq;
+        freq = TheGlobalSettings.radio.frequency;
+
+        segmentGlyph[3] = freq % 10;
+        freq /= 10;
+        segmentGlyph[2] = (freq % 10) | SEGMENT_DP;
+        freq /= 10;
+        segmentGlyph[1] = freq % 10;
+        freq /= 10;
+        if(freq)
+          segmentGlyph[0] = freq % 10;
+
         break;
       }
-      // fall-through
-    }
-    case SECONDARY_MODE_RADIO:
-    {
-      uint16_t freq;
-      freq = TheGlobalSettings.radio.frequency;
-
-      segmentDigits[DIGIT_4] = pgm_read_byte(BCDToSegment + (freq%10));
-      freq /= 10;
-      segmentDigits[DIGIT_3] = pgm_read_byte(BCDToSegment + (freq%10)) | SEG_DP;
-      freq /= 10;
-      segmentDigits[DIGIT_2] = pgm_read_byte(BCDToSegment + (freq%10));
-      freq /= 10;
-      if(freq)
-        segmentDigits[DIGIT_1] = pgm_read_byte(BCDToSegment + (freq%10));
-
-      break;
-    }
-    case SECONDARY_MODE_NAP:
-    {
-      uint8_t hours = TheNapTime / 60;
-      uint8_t mins = TheNapTime % 60;
-      segmentDigits[DIGIT_4] = pgm_read_byte(BCDToSegment + (mins%10));
-      mins /= 10;
-      segmentDigits[DIGIT_3] = pgm_read_byte(BCDToSegment + mins);
-      
-      if (hours)
+      case SECONDARY_MODE_NAP:
       {
-        segmentDigits[DIGIT_2] = pgm_read_byte(BCDToSegment + hours) | SEG_DP;
+        uint8_t hours = TheNapTime / 60;
+        uint8_t mins = TheNapTime % 60;
+        segmentGlyph[3] = mins % 10;
+        segmentGlyph[2] = mins / 10;
+      
+        if (hours)
+        {
+          segmentGlyph[1] = hours | SEGMENT_DP;
+        }
+        break;
       }
-      break;
-    }
-    case SECONDARY_MODE_SLEEP:
-    {
-      uint8_t hours = TheSleepTime / 60;
-      uint8_t mins = TheSleepTime % 60;
-      segmentDigits[DIGIT_4] = pgm_read_byte(BCDToSegment + (mins%10));
-      mins /= 10;
-      segmentDigits[DIGIT_3] = pgm_read_byte(BCDToSegment + mins);
+      case SECONDARY_MODE_SLEEP:
+      {
+        uint8_t hours = TheSleepTime / 60;
+        uint8_t mins = TheSleepTime % 60;
+        segmentGlyph[3] = mins % 10;
+        segmentGlyph[2] = mins / 10;
       
-      if (hours)
+        if (hours)
+        {
+          segmentGlyph[1] = hours | SEGMENT_DP;
+        }
+        break;
+      }
+      case SECONDARY_MODE_TIME_ADJUST:
       {
-        segmentDigits[DIGIT_2] = pgm_read_byte(BCDToSegment + hours) | SEG_DP;
+        uint8_t absAdjust;
+        if (TheGlobalSettings.time_adjust >= 0)
+        {
+          absAdjust = TheGlobalSettings.time_adjust;
+        }
+        else
+        {
+          absAdjust = -TheGlobalSettings.time_adjust;
+          segmentGlyph[0] = GLYPH_DASH;
+        }
+
+        segmentGlyph[1] = (absAdjust / 10) | SEGMENT_DP;
+        segmentGlyph[2] = absAdjust % 10;
+        break;
       }
-      break;
     }
-    case SECONDARY_MODE_TIME_ADJUST:
+  
+    if (blinkStatus < BLINK_PERIOD)
     {
-      uint8_t absAdjust;
-      if (TheGlobalSettings.time_adjust >= 0)
+      for (uint8_t j = 0, mask = 0x08; j < 4; ++j, mask >>= 1)
       {
-        absAdjust = TheGlobalSettings.time_adjust;
+        if (blinkMask & mask)
+          segmentGlyph[j] = GLYPH_BLANK;
       }
-      else
+    }
+  
+    static const uint8_t digitColumn[4] = { DIGIT_1, DIGIT_2, DIGIT_3, DIGIT_4 };
+    
+    for (uint8_t j = 0; j < 4; ++j)
+    {
+      if (segmentGlyph[j] != GLYPH_BLANK)
+        Segment_PutGlyph(rows, segmentGlyph[j], digitColumn[j]);
+    }
+    
+    // Only the rows that actually changed are dirty
+    for (uint8_t i = 0; i < PANEL_ROWS; ++i)
+    {
+      if (rows[i] != segmentRows[i])
       {
-        absAdjust = -TheGlobalSettings.time_adjust;
-        segmentDigits[DIGIT_1] = SEG_g;
+        segmentRows[i] = rows[i];
+        dirtyRows[SEGMENT_PANEL] |= 1 << i;
       }
-
-      segmentDigits[DIGIT_2] = pgm_read_byte(BCDToSegment + (absAdjust / 10)) | SEG_DP;
-      segmentDigits[DIGIT_3] = pgm_read_byte(BCDToSegment + (absAdjust % 10));
-      break;
     }
   }
   
-  if (blinkStatus < BLINK_PERIOD)
+  uint8_t leds = __ledColumns();
+  
+  if (leds != composedLeds)
   {
-    if (blinkMask & 0x08)
-      segmentDigits[DIGIT_1] = 0;
-    if (blinkMask & 0x04)
-      segmentDigits[DIGIT_2] = 0;
-    if (blinkMask & 0x02)
-      segmentDigits[DIGIT_3] = 0;
-    if (blinkMask & 0x01)
-      segmentDigits[DIGIT_4] = 0;
+    // LEDs span their entire column. The rows are recomposed from the cached
+    // digit rows, the dot matrix is left alone.
+    composedLeds = leds;
+    dirtyRows[SEGMENT_PANEL] = 0xff;
   }
-  
-  
-  for (uint8_t i = 0; i < 8; ++i)
+}
+
+static void __composeMatrixRow(const uint8_t i, uint8_t *matrix)
+{
+  if (myMainMode < MAIN_MODE_SLEEP)
   {
-    if (myMainMode < MAIN_MODE_SLEEP)
+    uint8_t mainDigit[4] = {0};
+    uint8_t dotMask = 0; 
+    uint8_t wday_mask = 0;
+    
+    if (mainDigitsValid)
     {
-      uint8_t mainDigit[4] = {0};
-      uint8_t dotMask = 0; 
-      uint8_t wday_mask = 0;
-      switch(myMainMode)
-      {
-        case MAIN_MODE_TIME:
-          mainDigit[0] = __getDigitMask(previousHour >> 4, TheDateTime.hour >> 4, i);
-          mainDigit[1] = __getDigitMask(previousHour &0xf, TheDateTime.hour & 0xf, i);
-          mainDigit[2] = __getDigitMask(previousMinute >> 4, TheDateTime.min >> 4, i);
-          mainDigit[3] = __getDigitMask(previousMinute &0xf, TheDateTime.min & 0xf, i);
+      for (uint8_t j = 0; j < 4; ++j)
+        mainDigit[j] = __getDigitMask(j, i);
+    }
+    
+    switch(myMainMode)
+    {
+      case MAIN_MODE_TIME:
+        dotMask =  (i == 1 || i == 5) ? 0x20 : 0;
+        wday_mask =  ( i == TheDateTime.wday - 1) ? 0x3: 0;
+        break;
+      case MAIN_MODE_DATE:
+        dotMask = (i < 2 ? 0x40 : (i <5 ? 0x20 : (i < 7 ? 0x10 : 0)));
+        wday_mask =  ( i == TheDateTime.wday - 1) ? 0x3: 0;
+        break;
+      case MAIN_MODE_ALARM:
+        if (alarm)
+        {
           dotMask =  (i == 1 || i == 5) ? 0x20 : 0;
-          wday_mask =  ( i == TheDateTime.wday - 1) ? 0x3: 0;
-          break;
-        case MAIN_MODE_DATE:
-          mainDigit[0] = __getDigitMaskSingle(TheDateTime.day >> 4, i);
-          mainDigit[1] = __getDigitMaskSingle(TheDateTime.day &0xf, i);
-          mainDigit[2] = __getDigitMaskSingle(TheDateTime.month >> 4, i);
-          mainDigit[3] = __getDigitMaskSingle(TheDateTime.month &0xf, i);
-          dotMask = (i < 2 ? 0x40 : (i <5 ? 0x20 : (i < 7 ? 0x10 : 0)));
-          wday_mask =  ( i == TheDateTime.wday - 1) ? 0x3: 0;
-          break;
-        case MAIN_MODE_ALARM:
-          if (alarm)
+          if (i == 7)
+            wday_mask = 0;
+          else
           {
-            mainDigit[0] = __getDigitMaskSingle(alarm->hour >>4, i);
-            mainDigit[1] = __getDigitMaskSingle(alarm->hour &0xf, i);
-            mainDigit[2] = __getDigitMaskSingle(alarm->min >> 4, i);
-            mainDigit[3] = __getDigitMaskSingle(alarm->min &0xf, i);
-            dotMask =  (i == 1 || i == 5) ? 0x20 : 0;
-            if (i == 7)
-              wday_mask = 0;
-            else
+            switch (alarm->flags & ALARM_DAY_BITS)
             {
-              switch (alarm->flags & ALARM_DAY_BITS)
-              {
-                case ALARM_DAY_DAILY:
-                  wday_mask = 3;
-                  break;
-                case ALARM_DAY_WEEK:
-                  wday_mask = (i < 5) ? 3 : 0;
-                  break;
-                case ALARM_DAY_WEEKEND:
-                  wday_mask = (i >= 5 && i < 7 ) ? 3 : 0;
-                  break;
-              }
+              case ALARM_DAY_DAILY:
+                wday_mask = 3;
+                break;
+              case ALARM_DAY_WEEK:
+                wday_mask = (i < 5) ? 3 : 0;
+                break;
+              case ALARM_DAY_WEEKEND:
+                wday_mask = (i >= 5 && i < 7 ) ? 3 : 0;
+                break;
             }
           }
-          break;
-      }
-      
-      if (blinkStatus < BLINK_PERIOD)
-      {
-        uint8_t digitMask = blinkMask & 0xff;
-        for (uint8_t j = 0, mask = 0x80; j < 4; ++j, mask >>= 1)
-        {
-          if (digitMask & mask)
-            mainDigit[j] = ( i == 7 ? 0x0f : 0);
         }
-        
-        if (blinkMask & 0x100)
-          wday_mask = (i == 7 ? 3 : 0);
+        break;
+    }
+    
+    if (blinkStatus < BLINK_PERIOD)
+    {
+      uint8_t digitMask = blinkMask & 0xff;
+      for (uint8_t j = 0, mask = 0x80; j < 4; ++j, mask >>= 1)
+      {
+        if (digitMask & mask)
+          mainDigit[j] = ( i == 7 ? 0x0f : 0);
       }
       
-      // day-of-week on 0 and 1, Digit 0 at 3, space at 7
-      data[0] = (mainDigit[0] <<3) | wday_mask ;
+      if (blinkMask & 0x100)
+        wday_mask = (i == 7 ? 3 : 0);
+    }
+    
+    // day-of-week on 0 and 1, Digit 0 at 3, space at 7
+    matrix[0] = (mainDigit[0] <<3) | wday_mask ;
 
-      // Digit 1 at 8-10, space at 11, dot at 12, space at 13, digit 2 at 14-17
+    // Digit 1 at 8-10, space at 11, dot at 12, space at 13, digit 2 at 14-17
 
-      data[1] = (mainDigit[1] | dotMask | (mainDigit[2] << 7));
-      
-      // space at 18, digit 3 at 19-23
-      data[2] = (mainDigit[2] >> 1) | (mainDigit[3] << 4);
-    }
-    else if (myMainMode == MAIN_MODE_SLEEP)
-    {
-      // Write out "SLEEP" bitmap
-      const uint8_t *b = Bitmap_Sleep + (i * 3);
-      data[0] = pgm_read_byte(b + 0);
-      data[1] = pgm_read_byte(b + 1);
-      data[2] = pgm_read_byte(b + 2);
-    }     
-    else if (myMainMode == MAIN_MODE_NAP)
+    matrix[1] = (mainDigit[1] | dotMask | (mainDigit[2] << 7));
+    
+    // space at 18, digit 3 at 19-23
+    matrix[2] = (mainDigit[2] >> 1) | (mainDigit[3] << 4);
+  }
+  else if (myMainMode == MAIN_MODE_SLEEP)
+  {
+    // Write out "SLEEP" bitmap
+    const uint8_t *b = Bitmap_Sleep + (i * 3);
+    matrix[0] = pgm_read_byte(b + 0);
+    matrix[1] = pgm_read_byte(b + 1);
+    matrix[2] = pgm_read_byte(b + 2);
+  }     
+  else if (myMainMode == MAIN_MODE_NAP)
+  {
+    // Write out "NAP" bitmap
+    const uint8_t *b = Bitmap_Nap + (i * 3);
+    matrix[0] = pgm_read_byte(b + 0);
+    matrix[1] = pgm_read_byte(b + 1);
+    matrix[2] = pgm_read_byte(b + 2);
+  }
+  
+  if (invertionMode == INVERTED)
+  {
+    matrix[0] = ~matrix[0];
+    matrix[1] = ~matrix[1];
+    matrix[2] = ~matrix[2];
+  }
+}
+
+static void __privateRender()
+{
+  for (uint8_t i = 0, rowMask = 1; i < PANEL_ROWS; ++i, rowMask <<= 1)
+  {
+    uint8_t dirtyPanels = 0;
+    
+    for (uint8_t j = 0, panelMask = 1; j < PANEL_COUNT; ++j, panelMask <<= 1)
     {
-      // Write out "NAP" bitmap
-      const uint8_t *b = Bitmap_Nap + (i * 3);
-      data[0] = pgm_read_byte(b + 0);
-      data[1] = pgm_read_byte(b + 1);
-      data[2] = pgm_read_byte(b + 2);
+      if (dirtyRows[j] & rowMask)
+        dirtyPanels |= panelMask;
     }
-    // Rotate the 7-segment data
-    const uint8_t row_mask = 1<<i;
-
-    data[3] = 0;
-
-    for(uint8_t j = 0, column_mask = 1; j < 8; ++j, column_mask <<= 1)
-      if (segmentDigits[j] & row_mask)
-        data[3] |= column_mask;
     
-    if (invertionMode == INVERTED)
+    if (!dirtyPanels)
+      continue;
+    
+    uint8_t data[PANEL_COUNT]; // Data to be sent to the panels
+    uint8_t *previous = previousContent + i * PANEL_COUNT;
+    
+    for (uint8_t j = 0; j < PANEL_COUNT; ++j)
+      data[j] = previous[j];
+    
+    if (dirtyPanels & (ALL_MATRIX_PANELS << MATRIX_PANEL))
+      __composeMatrixRow(i, data + MATRIX_PANEL);
+    
+    if (dirtyPanels & (1 << SEGMENT_PANEL))
+      data[SEGMENT_PANEL] = segmentRows[i] | composedLeds;
+    
+    // Only send the dirty panels whose content changed
+    uint8_t changedPanels = 0;
+    
+    for (uint8_t j = 0, panelMask = 1; j < PANEL_COUNT; ++j, panelMask <<= 1)
     {
-      data[0] = ~data[0];
-      data[1] = ~data[1];
-      data[2] = ~data[2];
+      if ((dirtyPanels & panelMask) && (forceRedraw || data[j] != previous[j]))
+      {
+        changedPanels |= panelMask;
+        previous[j] = data[j];
+      }
     }
     
-    if (0 != memcmp(data, previousContent + i * 4, 4))
-      SendRow(i, data);
-      
-    memcpy(previousContent + i * 4, data, 4);
+    if (changedPanels)
+      SendRow(i, data, changedPanels);
   }
-
+  
+  for (uint8_t j = 0; j < PANEL_COUNT; ++j)
+    dirtyRows[j] = 0;
+  
+  forceRedraw = 0;
 }
 
 void Renderer_Tick(uint8_t secondaryMode)
 {
   blinkStatus = (blinkStatus + 1) % ( 2 * BLINK_PERIOD);
   
-  _Bool doRender = 0;
-  
-  uint8_t ledBlinking = ledState & 0xaa; // Blink on 10 and 11, not on 00 and 01
-  
-  if (animationState & 0x80 || (blinkMask && (blinkStatus == 0 || blinkStatus == BLINK_PERIOD)) || ledBlinking != 0)
-  {
-    animationState &= 0x7f;
-    doRender = 1;
-  }
+  if (blinkMask && (blinkStatus == 0 || blinkStatus == BLINK_PERIOD))
+    __markBlinking(blinkMask);
   
-  if (animationState)
+  if (Animation_Running())
   {
-    animationState--;
+    __markMainDigits(Animation_Tick());
     
-    doRender = 1;
-    
-    if (animationState == 0)
+    if (!Animation_Running())
     {
+      // Transition done, the new digits are all that is left
       previousHour = TheDateTime.hour;
       previousMinute = TheDateTime.min;
+      mainChanged = 1;
     }
   } 
   
-  if (doRender)
-    __privateRender(secondaryMode);
+  Renderer_Render(secondaryMode);
+  
+#ifdef RENDERER_PROFILE
+  // Timer 1 restarted at the start of this frame; 1 tick = 64 cycles
+  uint16_t ticks = TCNT1;
+  
+  if (ticks > Renderer_MaxFrameTicks)
+    Renderer_MaxFrameTicks = ticks;
+#endif
+}
+
+void Renderer_Render(uint8_t secondaryMode)
+{
+  if (mainChanged)
+  {
+    mainChanged = 0;
+    __updateMainLayer();
+  }
+  
+  __updateSegmentLayer(secondaryMode);
+  
+  __privateRender();
+}
+
+bool Renderer_IsAnimating()
+{
+  uint8_t ledBlinking = ledState & 0xaa; // Blink on 10 and 11, not on 00 and 01
+  
+  return Animation_Running() || blinkMask || ledBlinking;
+}
+
+void Renderer_Redraw()
+{
+  forceRedraw = 1;
+  
+  for (uint8_t j = 0; j < PANEL_COUNT; ++j)
+    dirtyRows[j] = 0xff;
 }
 
 void Renderer_Update_Secondary()
 {
-  animationState |= 0x80;
+  secondaryChanged = 1;
 }
 
 void Renderer_SetLed(const uint8_t leftMostLedState, const uint8_t leftLedState, const uint8_t rightLedState, const uint8_t rightMostLedState)
 {
+  // Picked up by __updateSegmentLayer on the next tick
   ledState = rightMostLedState;
   ledState <<= 2;
   ledState |= rightLedState;
@@ -402,8 +667,6 @@ void Renderer_SetLed(const uint8_t leftMostLedState, const uint8_t leftLedState,
   ledState |= leftLedState;
   ledState <<= 2;
   ledState |= leftMostLedState;
-  
-  Renderer_Update_Secondary();
 }
 
 void Renderer_Update_Main(const uint8_t mainMode,const _Bool animate)
@@ -412,23 +675,55 @@ void Renderer_Update_Main(const uint8_t mainMode,const _Bool animate)
 
   myMainMode = mainMode;
   
+  // The 7-segment display may show (part of) the same data
+  secondaryChanged = 1;
+  
+  mainChanged = 1;
+  
   if (animate && dotmatrixChanged)
   {
-    animationState = 9;
+    // Start with the previous digits, bring in the changed ones
+    if (!Animation_Running())
+    {
+      uint8_t digits = 0;
+      
+      if ((previousHour ^ TheDateTime.hour) & 0xf0)
+        digits |= 0x1;
+      if ((previousHour ^ TheDateTime.hour) & 0x0f)
+        digits |= 0x2;
+      if ((previousMinute ^ TheDateTime.min) & 0xf0)
+        digits |= 0x4;
+      if ((previousMinute ^ TheDateTime.min) & 0x0f)
+        digits |= 0x8;
+      
+      Animation_Start(transition, digits);
+    }
   }
   else
   {
-    animationState = 1;
+    Animation_Stop();
+    previousHour = TheDateTime.hour;
+    previousMinute = TheDateTime.min;
   }
 }
 
+void Renderer_SetTransition(const enum enumTransition newTransition)
+{
+  transition = (uint8_t) newTransition;
+}
+
 void Renderer_SetFlashMask(const uint16_t mask)
 {
+  // Both the old and the new flashing parts may need redrawing
+  __markBlinking(blinkMask | mask);
   blinkMask = mask; 
 }
 
 
 void Renderer_SetInverted(const enum enumInvertionMode newInvertionMode)
 {
+  if (invertionMode != (uint8_t) newInvertionMode)
+    __markMatrix(ALL_MATRIX_PANELS, 0xff);
+  
   invertionMode = (uint8_t) newInvertionMode;
 }
@@ -19,6 +19,7 @@ PERFORMANCE OF THIS SOFTWARE.
 #include <stdbool.h>
 #include <inttypes.h>
 #include <settings.h>
+#include "Animation.h"
 
 enum enumMainMode
 {
@@ -41,8 +42,21 @@ enum enumSecondaryMode
   SECONDARY_MODE_TIME_ADJUST,
 };
 
+// Frame rate of the render clock. It only has to run while something on the
+// display moves, see Renderer_IsAnimating().
+#ifndef RENDERER_FPS
+#define RENDERER_FPS 50
+#endif
+
+#if RENDERER_FPS < 10 || RENDERER_FPS > 200
+#error "RENDERER_FPS out of range"
+#endif
+
 void Renderer_Init();
-void Renderer_Tick( const uint8_t secondaryMode ); // Must be called regularly for animations 
+void Renderer_Tick( const uint8_t secondaryMode ); // Advance animations by one frame and render. Call at RENDERER_FPS.
+void Renderer_Render( const uint8_t secondaryMode ); // Send pending changes, without advancing animations
+bool Renderer_IsAnimating(); // True while animations or blinking need Renderer_Tick()
+void Renderer_Redraw(); // Re-send everything on the next render, e.g. after Panels_Resync()
 
 // Update contents. if _animate is true, use "rolling" animation.
 void Renderer_Update_Main(const uint8_t mainMode,const bool animate);
@@ -70,5 +84,13 @@ enum enumInvertionMode
 
 void Renderer_SetInverted(const enum enumInvertionMode invertionMode);
 
+// Select the transition used when the time changes, see Animation.h
+void Renderer_SetTransition(const enum enumTransition transition);
+
+#ifdef RENDERER_PROFILE
+// Longest Renderer_Tick() so far, in timer 1 ticks of 64 cycles
+extern uint16_t Renderer_MaxFrameTicks;
+#endif
+
 #endif
 
@@ -18,9 +18,22 @@ PERFORMANCE OF THIS SOFTWARE.
 #include "SI4702.h"
 #include <stdbool.h>
 #include <util/delay.h>
+#include <util/atomic.h>
+#ifdef SI4702_STC_IRQ
+#include <avr/interrupt.h>
+#endif
+#ifdef SI4702_RDS
+#include "RDS.h"
+#endif
 
 #define SI4702_ADDR 0x20
 #define SI4702_RECOVERY_ATTEMPTS 3
+#define SI4702_I2C_RETRIES 1 // Polled continuously, so give up quickly
+
+// The SI4702 supports 400 KHz fast mode (see RADIO_KHZ in the Makefile)
+#ifndef SI4702_I2C_KHZ
+#define SI4702_I2C_KHZ 400
+#endif
 
 // The SI4702 has bigendian registers, the AVR is little endian. 
 // Work around this by not addressing the registers as 16 bits - it's not really that useful
@@ -61,7 +74,7 @@ uint8_t SI4702_regs[32];
 #define READ_CHANNEL_H 0x02
   #define BLERB(x) ((x & 0xC0) >> 6) // RDS Block B errors
   #define BLERC(x) ((x & 0x30) >> 4) // RDS Block C errors
-  #define BLERD(x) ((x & 0xc0) >> 2) // RDS block D erros
+  #define BLERD(x) ((x & 0x0c) >> 2) // RDS block D errors
   #define READ_CHANNEL_H_BITS 0x3 // ReadChannel[8:9]
 
 #define READ_CHANNEL_L 0x03
@@ -90,6 +103,7 @@ uint8_t SI4702_regs[32];
 
 #define DEVICEID_L     0x0d
   #define MFGID_L_BITS 0xff // bits 0-7 of manufacturer ID
+  #define SI4702_MFGID 0x242 // Silicon Labs
   
 // REGISTER 1
 #define CHIPID_H       0x0e
@@ -105,7 +119,7 @@ uint8_t SI4702_regs[32];
   #define DSMUTE  0x80 // Disable softmute
   #define DMUTE   0x40 // Disable mute
   #define MONO    0x20 // mono
-  #define RDSM	  0x08 // RDS mode (not supported)
+  #define RDSM	  0x08 // RDS mode: verbose, reports block errors (see SI4702_RDS)
   #define SKMODE  0x04 // Seek mode: stop seeking at band end
   #define SEEKUP  0x02 // Seek up
   #define SEEK    0x01 // Start seeking
@@ -124,9 +138,9 @@ uint8_t SI4702_regs[32];
 
 // REGISTER 4
 #define SYSCONFIG1_H 0x14
-  #define RDSIEN  0x80 // RDS interrupt enable (not supported)
-  #define STCIEN  0x40 // Seek/Tune interrupt enable (not supplied by breakout board)
-  #define RDS     0x10 // RDS enable (not supported)
+  #define RDSIEN  0x80 // RDS interrupt enable (GPIO2, see SI4702_STC_IRQ)
+  #define STCIEN  0x40 // Seek/Tune interrupt enable (GPIO2, see SI4702_STC_IRQ)
+  #define RDS     0x10 // RDS enable (see SI4702_RDS)
   #define DE      0x08 // De-emphasis. 0 for USA, 1 for rest of world
   #define AGCD    0x04 // Automatic Gain Control disable
 
@@ -145,7 +159,7 @@ uint8_t SI4702_regs[32];
   #define GPIO3_HIGH 0x30 // Force high
   #define GPIO3_BITS GPIO3_HIGH
 
-  // GPIO2 mode (not bonded out)
+  // GPIO2 mode (optionally wired to PB0)
   #define GPIO2_HI_Z 0x00
   #define GPIO2_INT  0x04 // Seek/Tune or RDS interrupt
   #define GPIO2_LOW  0x08 // force low
@@ -218,14 +232,116 @@ uint8_t SI4702_regs[32];
 #define BOOTCONFIG_L 0x1f
   // reserved
 
+// Poll_SI4702() reads the registers in the background, and uses the result on
+// the next poll. It only reads the status registers (A and B), and the RDS 
+// blocks (C - F) if RDS is decoded: registers 2 - 7 are written by us, and only
+// written back when one of them changed.
+#ifdef SI4702_RDS
+#define SI4702_STATUS_BYTES 12
+#else
+#define SI4702_STATUS_BYTES 4
+#endif
+
+// Writable registers changed since the last write-out. Bit 0 is register 2.
+#define DIRTY(reg) (1 << (((reg) - RELOCATED_REGISTER_2) >> 1))
+#define DIRTY_ALL 0x3f
+
+static volatile uint8_t dirtyRegs = 0;
+
+static void __writeDone(struct I2C_Transaction *t)
+{
+  if (t->status != I2C_OK)
+    dirtyRegs = DIRTY_ALL; // Retry on the next poll
+}
+
+// __writeDone() runs from the TWI ISR, so updates must be atomic
+static void __markDirty(uint8_t regs)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    dirtyRegs |= regs;
+  }
+}
+
+#ifdef SI4702_STC_IRQ
+// GPIO2 is wired to PB0 (PCINT0), and pulled low for at least 5 ms when a seek
+// or tune completes, or an RDS group arrives. Only then is the status read; 
+// idle polls cause no traffic.
+static volatile _Bool stcSignalled = 0;
+
+ISR(PCINT0_vect)
+{
+  if (!(PINB & _BV(PINB0)))
+    stcSignalled = 1;
+}
+
+_Bool SI4702_Signalled()
+{
+  return stcSignalled;
+}
+
+// GPIO2 floats while the radio is powered down or in reset
+static void __maskSignal()
+{
+  PCMSK0 &= ~_BV(PCINT0);
+  stcSignalled = 0;
+}
+#else
+#define __maskSignal()
+#endif
+
+#ifdef SI4702_PROFILE
+uint8_t SI4702_PollTicks = 0;
+uint8_t SI4702_MaxPollTicks = 0;
+
+static uint8_t pollStart;
+
+static void __pollDone(struct I2C_Transaction *t)
+{
+  SI4702_PollTicks = TCNT2 - pollStart;
+  
+  if (SI4702_PollTicks > SI4702_MaxPollTicks)
+    SI4702_MaxPollTicks = SI4702_PollTicks;
+}
+
+#define POLL_CALLBACK __pollDone
+#else
+#define POLL_CALLBACK 0
+#endif
+
+static struct I2C_Transaction pollRead = { SI4702_ADDR, 0, I2C_READ | I2C_NO_REG, SI4702_STATUS_BYTES, { SI4702_regs }, POLL_CALLBACK, I2C_IDLE, 0 };
+static struct I2C_Transaction pollWrite = { SI4702_ADDR, 0, I2C_NO_REG, 12, { SI4702_regs + RELOCATED_REGISTER_2 }, __writeDone, I2C_IDLE, 0 };
+
+// Wait for background transfers to complete, so they cannot overwrite registers 
+// that are about to be changed, or send half-changed ones.
+static void __syncRegs()
+{
+  if (pollWrite.status == I2C_PENDING)
+    I2C_Wait(&pollWrite);
+  if (pollRead.status == I2C_PENDING)
+    I2C_Wait(&pollRead);
+}
+
+uint16_t targetFreq = 0;
+enum {
+    seekIdle,
+    seekUp,
+    seekDown,
+    seekBusy,
+  } seekMode = seekIdle;
+
 static inline _Bool Read_SI4702()
 {
-  return Read_I2C_Raw(SI4702_ADDR, 32, SI4702_regs);
+  return Read_I2C_Raw(SI4702_ADDR, 32, SI4702_regs) == I2C_OK;
 }
 
 static inline _Bool Write_SI4702()
 {
-  return Write_I2C_Raw(SI4702_ADDR, 12, SI4702_regs + RELOCATED_REGISTER_2); 
+  if (Write_I2C_Raw(SI4702_ADDR, 12, SI4702_regs + RELOCATED_REGISTER_2) != I2C_OK)
+    return 0;
+  
+  dirtyRegs = 0;
+  return 1;
 }
 
 void SI4702_SetFrequency_intern(uint16_t frequency) // Frequency in .1 MHz 
@@ -246,6 +362,7 @@ void SI4702_SetFrequency_intern(uint16_t frequency) // Frequency in .1 MHz
 
   SI4702_regs[CHANNEL_L] = frequency & 0xff;
   SI4702_regs[CHANNEL_H] = ( SI4702_regs[CHANNEL_H] & (~CHANNEL_H_BITS) ) | (frequency >> 8);
+  __markDirty(DIRTY(CHANNEL_H));
 }
 
 uint16_t SI4702_GetFrequency()
@@ -277,18 +394,19 @@ uint16_t SI4702_GetFrequency()
 void SI4702_SetSeekThreshold(uint8_t threshold)
 {
   SI4702_regs[SYSCONFIG2_H] = threshold;
+  __markDirty(DIRTY(SYSCONFIG2_H));
 }
 
-// Set volume ( 0 = mute, 30 = max)
-void SI4702_SetVolume(uint8_t volume)
+static uint8_t volume = 0;
+
+static void __applyVolume()
 {
-  if (volume > 30)
-    return;
-    
-  if (volume > 15)
+  uint8_t level = volume;
+  
+  if (level > 15)
   {
     // Disable VOLEXT
-    volume -= 15;
+    level -= 15;
     SI4702_regs[SYSCONFIG3_H] &= ~VOLEXT;
   }
   else
@@ -297,95 +415,305 @@ void SI4702_SetVolume(uint8_t volume)
     SI4702_regs[SYSCONFIG3_H] |= VOLEXT;
   }
   SI4702_regs[SYSCONFIG2_L] &= ~VOLUME_BITS;
-  SI4702_regs[SYSCONFIG2_L] |= (volume & 0x0f);
+  SI4702_regs[SYSCONFIG2_L] |= (level & 0x0f);
+}
+
+// Power state. Starting and stopping take a few CLOCK_TICKs, see SI4702_Step().
+static enum SI4702_State state = SI4702_OFF;
+
+enum powerStep
+{
+  stepIdle,
+  stepOscillator, // Reset done, enable the oscillator
+  stepConfigure,  // Oscillator settled, power up
+  stepShutdown,   // Powered down, wait for the audio to stop
+  stepStandby,    // Powered down with the oscillator running, until it times out
+};
+
+static enum powerStep step = stepIdle;
+static uint16_t waitTicks = 0;
+static uint8_t attempts = 0;
+static _Bool standbyOnly = 0; // Stop at standby when the oscillator has settled
+
+// Number of CLOCK_TICKs (~49 ms) to wait for at least 'ms'
+#define SI4702_TICKS(ms) (((ms) + 47) / 48)
+
+// Keep the oscillator running this long after the radio was turned off, so it
+// can be turned back on without the reset and the 125 ms settling time.
+#ifndef SI4702_STANDBY_MINUTES
+#define SI4702_STANDBY_MINUTES 5
+#endif
+
+// Set volume ( 0 = mute, 30 = max). Applied when the radio is started, if it isn't yet.
+void SI4702_SetVolume(uint8_t newVolume)
+{
+  if (newVolume > 30)
+    return;
   
+  volume = newVolume;
+  
+  if (state != SI4702_ON)
+    return;
+  
+  __syncRegs();
+  __applyVolume();
   Write_SI4702();
 }
 
 uint8_t SI4702_GetVolume()
 {
-  uint8_t ret = SI4702_regs[SYSCONFIG2_L] & VOLUME_BITS;
-  if ((SI4702_regs[SYSCONFIG3_H] & VOLEXT) == 0)
-    ret += 15;
-  
-  return ret;
+  return volume;
 }
 
-_Bool Init_SI4702()
+// Pulse the reset line, with SDA low to select the 2-wire interface. Takes 1 ms; the
+// SI4702 may be addressed 10 ms later.
+static void __reset()
 {
-  for(uint8_t attempt = 0; attempt < SI4702_RECOVERY_ATTEMPTS; ++attempt)
-  {
-    // Disable I2C module
-    TWCR &= ~(_BV(TWEN));
+  __syncRegs(); // The I2C module is about to be disabled
+  
+  // Disable I2C module
+  TWCR &= ~(_BV(TWEN));
 
-    PORTC &= ~(_BV(PORTC3)); // Clear port c3
-    DDRC |= _BV(PORTC3); // Port C3 (reset input of SI4702) to output
-    
-    _delay_us(500); 
-    // Clear port c4 (SDA)
-    PORTC &= ~(_BV(PORTC4));
-    
-    _delay_us(500);  // Si4702 datasheet: > 100 us
-    // assert C3 (SI4702 reset)
-    DDRC &= ~_BV(PORTC3); // use external pull-up to 3v3
-    
-    _delay_us(10); // Si4702 datasheet: > 30 ns
-    // Assert C4
-    PORTC |= _BV(PORTC4); 
+  PORTC &= ~(_BV(PORTC3)); // Clear port c3
+  DDRC |= _BV(PORTC3); // Port C3 (reset input of SI4702) to output
+  
+  _delay_us(500); 
+  // Clear port c4 (SDA)
+  PORTC &= ~(_BV(PORTC4));
+  
+  _delay_us(500);  // Si4702 datasheet: > 100 us
+  // assert C3 (SI4702 reset)
+  DDRC &= ~_BV(PORTC3); // use external pull-up to 3v3
+  
+  _delay_us(10); // Si4702 datasheet: > 30 ns
+  // Assert C4
+  PORTC |= _BV(PORTC4); 
 
-    _delay_ms(10); // Si4702 datasheet: > 300 ns 
+  TWCR |= _BV(TWEN); // enable I2C, the DS1307 may use it in the meantime
+  
+  step = stepOscillator;
+  waitTicks = SI4702_TICKS(10);
+}
 
-    TWCR |= _BV(TWEN); // enable I2C
-    
-    // Read current registers
-    if (!Read_SI4702())
-      continue;
-      
-    // Enable the oscillator
-    SI4702_regs[TEST1_H] |= XOSCEN;
-    // Writeout
-    if (!Write_SI4702())
-      continue;
-
-    _delay_ms(125); // Allow oscillator to settle
-    if (Read_SI4702())
-      return 1; // Success!
-  }
+_Bool Init_SI4702()
+{
+  I2C_SetRetries(SI4702_ADDR, SI4702_I2C_RETRIES);
+  I2C_SetSpeed(SI4702_ADDR, I2C_TWBR(SI4702_I2C_KHZ), 0);
   
-  return 0; // Error 
+  // Hold the SI4702 in a known state; SI4702_PowerOn() does the rest
+  __reset();
+  step = stepIdle;
+  state = SI4702_OFF;
+  
+  return 1;
+}
+
+// Start the radio up to the point where the oscillator runs.
+static void __coldStart()
+{
+  attempts = 0;
+  state = SI4702_STARTING;
+  __reset();
 }
 
 _Bool SI4702_PowerOn()
 {
-  if (!Init_SI4702())
-    return 0; // Restart failed
+  standbyOnly = 0;
   
-  SI4702_regs[POWERCONFIG_H] = DSMUTE | DMUTE | MONO;
-  SI4702_regs[POWERCONFIG_L] = ENABLE ;
-
-  SI4702_regs[SYSCONFIG1_H] |= DE;  // Use European  de-emphasis
-  SI4702_regs[SYSCONFIG2_L]  = SPACE_100KHZ | BAND_US_EU;  // European spacing
-  SI4702_SetSeekThreshold(20);
+  if (state == SI4702_ON || state == SI4702_STARTING)
+    return 1;
+  
+  targetFreq = 0;
+  seekMode = seekIdle;
+  
+  if (state == SI4702_STANDBY)
+  {
+    // Warm start: the oscillator already runs, power up on the next tick. Falls 
+    // back to a cold start if the registers do not read back as expected.
+    attempts = 0;
+    state = SI4702_STARTING;
+    step = stepConfigure;
+    waitTicks = 0;
+  }
+  else
+  {
+    __coldStart();
+  }
   
-  return Write_SI4702();
+  return 1;
+}
+
+void SI4702_Standby()
+{
+  if (state == SI4702_OFF || state == SI4702_FAILED)
+  {
+    standbyOnly = 1;
+    __coldStart();
+  }
+  else if (state == SI4702_STANDBY)
+  {
+    waitTicks = SI4702_TICKS(SI4702_STANDBY_MINUTES * 60000UL); // Extend
+  }
 }
 
 void SI4702_PowerOff()
 {
+  standbyOnly = 0;
+  
+  if (state == SI4702_OFF || state == SI4702_STANDBY || state == SI4702_STOPPING)
+    return;
+  
+  if (state == SI4702_STARTING || state == SI4702_FAILED)
+  {
+    // Nothing to power down. Abort the start by holding the chip in reset, 
+    // which stops the oscillator as well.
+    PORTC &= ~(_BV(PORTC3));
+    DDRC |= _BV(PORTC3);
+    __maskSignal();
+    step = stepIdle;
+    state = SI4702_OFF;
+    return;
+  }
+  
+  __syncRegs();
   Read_SI4702(); // Some registers may have shifted during takeoff
   SI4702_regs[POWERCONFIG_L] |= DISABLE;
   Write_SI4702();
-  _delay_ms(125); // Allow oscillator to settle
-  Read_SI4702(); // Some registers may have shifted during takeoff
+  
+  state = SI4702_STOPPING;
+  step = stepShutdown;
+  waitTicks = SI4702_TICKS(125);
 }
 
-uint16_t targetFreq = 0;
-enum {
-    seekIdle,
-    seekUp,
-    seekDown,
-    seekBusy,
-  } seekMode = seekIdle;
+static void __standby()
+{
+  __maskSignal();
+  state = SI4702_STANDBY;
+  step = stepStandby;
+  waitTicks = SI4702_TICKS(SI4702_STANDBY_MINUTES * 60000UL);
+}
+
+enum SI4702_State SI4702_GetState()
+{
+  return state;
+}
+
+static void __retry()
+{
+  if (++attempts < SI4702_RECOVERY_ATTEMPTS)
+  {
+    __reset();
+  }
+  else
+  {
+    __maskSignal();
+    step = stepIdle;
+    state = SI4702_FAILED;
+  }
+}
+
+_Bool SI4702_Step()
+{
+  if (step == stepIdle)
+    return 0;
+  
+  if (waitTicks)
+  {
+    --waitTicks;
+    return 0;
+  }
+  
+  const enum SI4702_State previousState = state;
+  
+  switch (step)
+  {
+    case stepIdle:
+      break;
+    case stepOscillator:
+      // Read current registers, and enable the oscillator
+      if (!Read_SI4702())
+      {
+        __retry();
+        break;
+      }
+      
+      SI4702_regs[TEST1_H] |= XOSCEN;
+      if (!Write_SI4702())
+      {
+        __retry();
+        break;
+      }
+      
+      step = stepConfigure;
+      waitTicks = SI4702_TICKS(125); // Allow oscillator to settle
+      break;
+    case stepConfigure:
+      // Also checks that a warm start still finds the oscillator running
+      if (!Read_SI4702() || !(SI4702_regs[TEST1_H] & XOSCEN) ||
+          (SI4702_regs[DEVICEID_H] & MFGID_H_BITS) != (SI4702_MFGID >> 8) || SI4702_regs[DEVICEID_L] != (SI4702_MFGID & 0xff))
+      {
+        __retry();
+        break;
+      }
+      
+      if (standbyOnly)
+      {
+        __standby();
+        break;
+      }
+      
+      SI4702_regs[POWERCONFIG_H] = DSMUTE | DMUTE | MONO;
+      SI4702_regs[POWERCONFIG_L] = ENABLE ;
+
+      SI4702_regs[SYSCONFIG1_H] |= DE;  // Use European  de-emphasis
+      SI4702_regs[SYSCONFIG2_L]  = SPACE_100KHZ | BAND_US_EU;  // European spacing
+      SI4702_SetSeekThreshold(20);
+      __applyVolume();
+      
+#ifdef SI4702_STC_IRQ
+      // Signal seek/tune completion on GPIO2
+      SI4702_regs[SYSCONFIG1_H] |= STCIEN;
+      SI4702_regs[SYSCONFIG1_L] = (SI4702_regs[SYSCONFIG1_L] & ~GPIO2_BITS) | GPIO2_INT;
+      
+      DDRB &= ~_BV(PORTB0);
+      PORTB |= _BV(PORTB0); // GPIO2 is push-pull, but floats while the SI4702 is in reset
+      PCMSK0 |= _BV(PCINT0);
+      PCICR |= _BV(PCIE0);
+#endif
+#ifdef SI4702_RDS
+      // Verbose mode, to filter on the block errors
+      SI4702_regs[POWERCONFIG_H] |= RDSM;
+      SI4702_regs[SYSCONFIG1_H] |= RDS;
+#ifdef SI4702_STC_IRQ
+      SI4702_regs[SYSCONFIG1_H] |= RDSIEN;
+#endif
+      RDS_Reset();
+#endif
+      
+      if (!Write_SI4702())
+      {
+        __retry();
+        break;
+      }
+      
+      step = stepIdle;
+      state = SI4702_ON;
+      break;
+    case stepShutdown:
+      Read_SI4702(); // Some registers may have shifted during takeoff
+      __standby();
+      break;
+    case stepStandby:
+      // Standby timed out, stop the oscillator as well
+      SI4702_regs[TEST1_H] &= ~XOSCEN;
+      Write_SI4702();
+      step = stepIdle;
+      state = SI4702_OFF;
+      break;
+  }
+  
+  return state != previousState;
+}
 
 void SI4702_SetFrequency(uint16_t freq)
 {
@@ -426,22 +754,70 @@ void SI4702_Tune(_Bool seekUp)
   targetFreq = freq ;
 }
 
+#ifdef SI4702_RDS
+static void __decodeRDS()
+{
+  uint16_t blocks[4];
+  const uint8_t errors[4] = { BLERA(SI4702_regs[STATUS_RSSI_H]), BLERB(SI4702_regs[READ_CHANNEL_H]), 
+                              BLERC(SI4702_regs[READ_CHANNEL_H]), BLERD(SI4702_regs[READ_CHANNEL_H]) };
+  
+  for (uint8_t i = 0; i < 4; ++i)
+    blocks[i] = (SI4702_regs[RDSA_H + 2 * i] << 8) | SI4702_regs[RDSA_L + 2 * i];
+  
+  RDS_Decode(blocks, errors);
+}
+#endif
+
 _Bool Poll_SI4702()
 {
   _Bool returnValue = 0;
   
-  Read_SI4702(); // Some registers may have shifted during takeoff
+  if (state != SI4702_ON)
+    return 0; // Still starting, see SI4702_Step()
+  
+  // Previous poll still in progress. Without a pending read-back (SI4702_STC_IRQ)
+  // the write-out must be checked as well, as it cannot be queued twice.
+  if (pollRead.status == I2C_PENDING || pollWrite.status == I2C_PENDING)
+    return 0;
   
+#ifdef SI4702_STC_IRQ
+  _Bool signalled;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    signalled = stcSignalled;
+    stcSignalled = 0;
+  }
+  
+  // Short enough to read right away, so completion is handled without delay
+  if (signalled)
+    Read_I2C_Raw(SI4702_ADDR, SI4702_STATUS_BYTES, SI4702_regs);
+#endif
+  
+  // SI4702_regs holds the result of the previous poll (or of the last blocking
+  // read).
   if (SI4702_regs[STATUS_RSSI_H] & STC)
   {
-    // Stop tuning
+    // Stop tuning. This clears STC.
     SI4702_regs[CHANNEL_H] &= ~TUNE;
     SI4702_regs[POWERCONFIG_H] &=~(SEEK);
+    SI4702_regs[STATUS_RSSI_H] &= ~STC;
+    __markDirty(DIRTY(CHANNEL_H) | DIRTY(POWERCONFIG_H));
     seekMode = seekIdle;
     returnValue = 1;
+#ifdef SI4702_RDS
+    RDS_Reset(); // Tuned to another station
+#endif
   }
   else
   {
+#ifdef SI4702_RDS
+    if (SI4702_regs[STATUS_RSSI_H] & RDSR)
+    {
+      __decodeRDS();
+      SI4702_regs[STATUS_RSSI_H] &= ~RDSR; // Handled
+    }
+#endif
+    
     if (targetFreq)
     {
       SI4702_SetFrequency_intern(targetFreq);
@@ -449,6 +825,7 @@ _Bool Poll_SI4702()
       // Abort seek, should it be in progress      
       //SI4702_regs[POWERCONFIG_H] &= (SEEK);
       SI4702_regs[CHANNEL_H] |= TUNE;
+      __markDirty(DIRTY(CHANNEL_H));
     } 
     
     switch(seekMode)
@@ -458,17 +835,43 @@ _Bool Poll_SI4702()
 	break;
       case seekUp:
 	SI4702_regs[POWERCONFIG_H] |= SEEKUP | SEEK;
+	__markDirty(DIRTY(POWERCONFIG_H));
 	seekMode = seekBusy;
 	break;
       case seekDown:
 	SI4702_regs[POWERCONFIG_H] &= ~SEEKUP;
 	SI4702_regs[POWERCONFIG_H] |= (SEEK);
+	__markDirty(DIRTY(POWERCONFIG_H));
 	seekMode = seekBusy;
 	break;
     }
   }
   
-  Write_SI4702();
+  // Write out up to the last changed register, and read back the status for 
+  // the next poll. 
+#ifdef SI4702_PROFILE
+  pollStart = TCNT2;
+#endif
+  uint8_t dirty;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    dirty = dirtyRegs;
+    dirtyRegs = 0;
+  }
+  
+  if (dirty)
+  {
+    uint8_t amount = 12;
+    while (!(dirty & DIRTY(RELOCATED_REGISTER_2 + amount - 2)))
+      amount -= 2;
+    
+    pollWrite.amount = amount;
+    I2C_Submit(&pollWrite);
+  }
+  
+#ifndef SI4702_STC_IRQ
+  I2C_Submit(&pollRead);
+#endif
   
   return returnValue;
 }
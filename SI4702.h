@@ -16,6 +16,16 @@ PERFORMANCE OF THIS SOFTWARE.
 #ifndef __SI4702_H__
 #define __SI4702_H__
 
+enum SI4702_State
+{
+  SI4702_OFF,
+  SI4702_STARTING,
+  SI4702_ON,
+  SI4702_STOPPING,
+  SI4702_STANDBY, // Off, but the oscillator runs so it can start right away
+  SI4702_FAILED,
+};
+
 _Bool Init_SI4702();
 _Bool Poll_SI4702();
 void SI4702_Seek(_Bool seekUp);
@@ -24,7 +34,28 @@ uint16_t SI4702_GetFrequency();
 void SI4702_SetFrequency(uint16_t frequency);
 void SI4702_SetVolume(uint8_t volume);
 uint8_t SI4702_GetVolume();
+// Powering on and off happen in the background, driven by SI4702_Step(). 
 _Bool SI4702_PowerOn();
+// Turning the radio off leaves it in standby for a few minutes.
 void SI4702_PowerOff();
+// Start the oscillator (or keep it running) without turning the radio on.
+void SI4702_Standby();
+enum SI4702_State SI4702_GetState();
+// Call on every CLOCK_TICK. Returns 1 when the state changed.
+_Bool SI4702_Step();
+
+#ifdef SI4702_STC_IRQ
+// GPIO2 signalled seek/tune completion; call Poll_SI4702() to handle it.
+_Bool SI4702_Signalled();
+#else
+#define SI4702_Signalled() 0
+#endif
+
+#ifdef SI4702_PROFILE
+// Bus time of the last and the longest poll (write-out plus read-back), in 
+// timer 2 ticks of 64 us
+extern uint8_t SI4702_PollTicks;
+extern uint8_t SI4702_MaxPollTicks;
+#endif
 #endif
 
@@ -125,59 +125,137 @@ uint8_t GetDateOfLastSunday(uint8_t month, uint8_t year)
   return BCDSub(lastDayOfMonth, weekdayOfLastDay);
 }
 
-_Bool IsDSTActive(const struct DateTime *timestamp, _Bool timestampIsUTC)
+// Days before the first of each month, in a non-leap year
+const uint16_t PROGMEM daysBeforeMonth[] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+uint32_t DateTimeToEpoch(const struct DateTime *timestamp)
 {
-  // DST is active from the last sunday of march until the last sunday of october. 
-  if (timestamp->month < 3 || timestamp->month > 0x10) // jan, feb, nov, dec
-  {
-    return false;
-  } else if (timestamp->month > 3 && timestamp->month < 0x10) // apr, may, jun, jul, aug, sept
-  {
-    return true;
-  }
+  const uint8_t year = BCDToBin(timestamp->year);
+  const uint8_t month = BCDToBin(timestamp->month);
+  
+  // 2000 is a leap year, so there are (year + 3) / 4 leap days before this year.
+  // Unsigned: 365 * 99 does not fit in a 16-bit int.
+  uint16_t days = 365U * year + (year + 3) / 4 + pgm_read_word(daysBeforeMonth + month - 1) + BCDToBin(timestamp->day) - 1;
+  if (month > 2 && (year % 4) == 0)
+    days++;
+  
+  uint32_t epoch = (uint32_t) days * 24 + BCDToBin(timestamp->hour);
+  epoch = epoch * 60 + BCDToBin(timestamp->min);
+  return epoch * 60 + BCDToBin(timestamp->sec);
+}
+
+void EpochToDateTime(uint32_t epoch, struct DateTime *timestamp)
+{
+  timestamp->sec = BinToBCD(epoch % 60);
+  epoch /= 60;
+  timestamp->min = BinToBCD(epoch % 60);
+  epoch /= 60;
+  timestamp->hour = BinToBCD(epoch % 24);
+  
+  uint16_t days = epoch / 24;
+  timestamp->wday = ((days + 5) % 7) + 1; // 2000-01-01 was a saturday
   
-  // march or october. Transition day is the last sunday of this month.
-  const uint8_t transitionDay = GetDateOfLastSunday(timestamp->month, timestamp->year);
-  _Bool pastTransitionDay;
-  if (timestamp->day == transitionDay)
+  // Blocks of 4 years, starting with a leap year
+  uint8_t year = (days / 1461) * 4;
+  days %= 1461;
+  
+  if (days >= 366)
   {
-    // Transition from CET to CEST is at 02:00 UTC+1, or at 1:00 UTC.
-    // Transition from CEST to CET is at 03:00 UTC+2, or at 1:00 UTC.
-    if (timestampIsUTC)
-      pastTransitionDay = (timestamp->hour > 0);
-    else
+    days -= 366;
+    year++;
+    while (days >= 365)
     {
-      // 02:00 - 03:00 occurs twice in october. 
-      // For the sake of simplicity, assume DST is no longer in effect when time is set after 02:00
-      pastTransitionDay = (timestamp->hour >= 2); 
+      days -= 365;
+      year++;
     }
   }
-  else
+  
+  const _Bool leapYear = (year % 4) == 0;
+  uint8_t month = 12;
+  uint16_t firstDay;
+  
+  while ((firstDay = pgm_read_word(daysBeforeMonth + month - 1) + (leapYear && month > 2)) > days)
+    --month;
+  
+  timestamp->day = BinToBCD(days - firstDay + 1);
+  timestamp->month = BinToBCD(month);
+  timestamp->year = BinToBCD(year);
+}
+
+// DST transitions of the cached year, as UTC instants. DST is active from the
+// last sunday of march until the last sunday of october, both at 01:00 UTC.
+static uint32_t dstYearStart = 1, dstYearEnd = 0; // Nothing cached yet
+static uint32_t dstStart, dstEnd;
+
+static void __cacheTransitions(uint32_t epoch)
+{
+  struct DateTime date;
+  EpochToDateTime(epoch, &date);
+  
+  date.sec = date.min = date.hour = 0;
+  date.day = date.month = 1;
+  dstYearStart = DateTimeToEpoch(&date);
+  dstYearEnd = dstYearStart + (BCDToBin(date.year) % 4 == 0 ? 366UL : 365UL) * 24 * 3600;
+  
+  date.hour = 1;
+  date.month = 3;
+  date.day = GetDateOfLastSunday(date.month, date.year);
+  dstStart = DateTimeToEpoch(&date);
+  
+  date.month = 0x10;
+  date.day = GetDateOfLastSunday(date.month, date.year);
+  dstEnd = DateTimeToEpoch(&date);
+}
+
+_Bool IsDSTActiveAt(uint32_t epoch, _Bool epochIsUTC)
+{
+  if (!epochIsUTC)
   {
-    pastTransitionDay = (timestamp->day > transitionDay);
+    // Transition from CET to CEST is at 02:00 UTC+1, from CEST to CET at 03:00 UTC+2.
+    // 02:00 - 03:00 occurs twice in october. For the sake of simplicity, assume DST is 
+    // no longer in effect then, i.e. treat local time as UTC+1 throughout.
+    epoch = epoch > 3600 ? epoch - 3600 : 0; // Not before 2000
   }
   
-  return (timestamp->month == 3 ? pastTransitionDay : !pastTransitionDay);
+  if (epoch < dstYearStart || epoch >= dstYearEnd)
+    __cacheTransitions(epoch);
+  
+  return epoch >= dstStart && epoch < dstEnd;
 }
 
-void UTCToCentralEuropeanTime(struct DateTime *timestamp)
+_Bool IsDSTActive(const struct DateTime *timestamp, _Bool timestampIsUTC)
 {
-  if (IsDSTActive(timestamp, true))
-    timestamp->hour = BCDAdd(timestamp->hour, 2);
+  return IsDSTActiveAt(DateTimeToEpoch(timestamp), timestampIsUTC);
+}
+
+void EpochToCentralEuropeanTime(uint32_t epoch, struct DateTime *timestamp)
+{
+  if (IsDSTActiveAt(epoch, true))
+    epoch += 2 * 3600;
   else
-    timestamp->hour = BCDAdd(timestamp->hour, 1);
+    epoch += 3600;
     
-  NormalizeHours(timestamp);
+  EpochToDateTime(epoch, timestamp);
 }
 
-void CentralEuropeanTimeToUTC(struct DateTime *timestamp)
+uint32_t CentralEuropeanTimeToEpoch(const struct DateTime *timestamp)
 {
-  if (IsDSTActive(timestamp, false))
-    timestamp->hour = BCDSub(timestamp->hour, 2);
+  const uint32_t epoch = DateTimeToEpoch(timestamp);
+  
+  if (IsDSTActiveAt(epoch, false))
+    return epoch - 2 * 3600;
   else
-    timestamp->hour = BCDSub(timestamp->hour, 1);
-    
-  NormalizeHours(timestamp);
+    return epoch - 3600;
+}
+
+void UTCToCentralEuropeanTime(struct DateTime *timestamp)
+{
+  EpochToCentralEuropeanTime(DateTimeToEpoch(timestamp), timestamp);
+}
+
+void CentralEuropeanTimeToUTC(struct DateTime *timestamp)
+{
+  EpochToDateTime(CentralEuropeanTimeToEpoch(timestamp), timestamp);
 }
 
 // Use a naive lookup table
@@ -31,4 +31,15 @@ _Bool IsDSTActive(const struct DateTime *timestamp, _Bool timestampIsUTC);
 
 void CentralEuropeanTimeToUTC(struct DateTime *TheDateTime);
 void UTCToCentralEuropeanTime(struct DateTime *TheDateTime);
+
+// Binary time: seconds since 2000-01-01 00:00:00. Good until 2136, but the
+// DateTime year only goes up to 2099.
+uint32_t DateTimeToEpoch(const struct DateTime *timestamp);
+void EpochToDateTime(uint32_t epoch, struct DateTime *timestamp); // Includes the weekday
+
+// Transitions are cached per year, so this is cheap as long as the year does not change.
+_Bool IsDSTActiveAt(uint32_t epoch, _Bool epochIsUTC);
+
+uint32_t CentralEuropeanTimeToEpoch(const struct DateTime *timestamp);
+void EpochToCentralEuropeanTime(uint32_t epoch, struct DateTime *timestamp);
 #endif
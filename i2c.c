@@ -15,236 +15,764 @@ PERFORMANCE OF THIS SOFTWARE.
 */
 #include "i2c.h"
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 #include <util/delay.h>
+#include <string.h>
 
 #define I2C_RECOVERY_ATTEMPTS 5
 
-static void I2CWait()
+// Per-slave settings and statistics. Slaves get an entry when they are first
+// addressed, or configured.
+#define I2C_MAX_DEVICES 2
+#define I2C_DEFAULT_RETRIES 2
+#define I2C_DEFAULT_TWBR I2C_TWBR(100)
+
+struct I2C_Device
+{
+  uint8_t addr; // 0 if unused
+  uint8_t retries;
+  uint8_t twbr;
+  uint8_t twps;
+#ifdef I2C_TELEMETRY
+  struct I2C_Stats stats;
+#endif
+};
+
+static struct I2C_Device devices[I2C_MAX_DEVICES];
+
+static struct I2C_Device *__findDevice(uint8_t addr)
 {
-  while (!(TWCR & _BV(TWINT)))
-    ; // Wait
+  addr &= 0xfe;
+  
+  for (uint8_t i = 0; i < I2C_MAX_DEVICES; ++i)
+  {
+    if (devices[i].addr == addr)
+      return &devices[i];
+  }
+  
+  return 0;
 }
 
-#define MIN_NR_RECOVERY_BITS 9  // 8 data bits + ack.
+// Find the entry for a slave, or claim a free one. Returns 0 if the table is full.
+static struct I2C_Device *__claimDevice(uint8_t addr)
+{
+  struct I2C_Device *device = __findDevice(addr);
+  
+  if (!device)
+  {
+    device = __findDevice(0); // Claim a free entry
+    if (device)
+    {
+      device->addr = addr & 0xfe;
+      device->retries = I2C_DEFAULT_RETRIES;
+      device->twbr = I2C_DEFAULT_TWBR;
+      device->twps = 0;
+    }
+  }
+  
+  return device;
+}
 
-static void _recovery()
+void I2C_SetRetries(uint8_t addr, uint8_t retries)
 {
-  // Start request could not be sent. This means the bus is stuck, and needs to be recovered.
+  struct I2C_Device *device = __claimDevice(addr);
   
-  TWCR = (1 << TWINT)|(1 << TWSTO); // According to the data sheet, this will release the bus.
+  if (device)
+    device->retries = retries;
+}
+
+void I2C_SetSpeed(uint8_t addr, uint8_t twbr, uint8_t twps)
+{
+  struct I2C_Device *device = __claimDevice(addr);
   
-  // Disable I2C module, and perform recovery procedure.
-  TWCR &= ~_BV(TWEN);
+  if (device)
+  {
+    device->twbr = twbr;
+    device->twps = twps;
+  }
+}
+
+// Transaction queue. Transactions are linked through their 'next' field, the
+// head of the queue is the one on the bus. The TWI interrupt advances the
+// state machine below, and starts the next transaction when one completes.
+
+static struct I2C_Transaction * volatile queueHead = 0;
+static struct I2C_Transaction * volatile queueTail = 0;
+
+static struct I2C_Device *device; // Of the transaction on the bus, may be 0
+static uint8_t position;       // Data bytes transferred so far
+static uint8_t segment;        // Current buffer of a vectored write
+static uint8_t offset;         // Position in that buffer
+static uint8_t startAttempts;
+static uint8_t retriesLeft;
+static _Bool   started;        // START condition was sent successfully
+static _Bool   regSent;        // Register address was sent
+
+#ifdef I2C_TELEMETRY
+static struct I2C_Record history[I2C_HISTORY_SIZE];
+static uint8_t historyHead = 0; // Next record to write
+static uint8_t lastTicks;
+static uint16_t elapsedTicks; // Of the transaction on the bus
+
+static inline void __startClock()
+{
+  lastTicks = TCNT2;
+  elapsedTicks = 0;
+}
+
+// Timer 2 wraps every 16 ms, so time is added up on every bus event; these are
+// closer together than that, except for a stall caught by I2C_Tick().
+static void __clockTick(_Bool stalled)
+{
+  uint8_t now = TCNT2;
+  
+  if (elapsedTicks < 256)
+    elapsedTicks += stalled ? 256 : (uint8_t) (now - lastTicks);
+  lastTicks = now;
+}
+
+static void __record(struct I2C_Transaction *t, uint8_t status)
+{
+  struct I2C_Record *record = &history[historyHead];
   
-  DDRC &= ~(_BV(PORTC4)); // Port C4 (SDA) to input
-  DDRC |= _BV(PORTC5); // Port C5 (SDL) to output
+  record->addr = t->addr & 0xfe;
+  record->amount = position;
+  record->status = status;
+  __clockTick(0);
+  record->ticks = elapsedTicks > 255 ? 255 : elapsedTicks;
   
-  // Send pulses along SCL until at least MIN_NR_RECOVERY_BITS consecutive "ones" are read back.
+  if (++historyHead == I2C_HISTORY_SIZE)
+    historyHead = 0;
   
-  for( uint8_t recoveryPhase = MIN_NR_RECOVERY_BITS; recoveryPhase != 0; )
+  if (device)
   {
-    PORTC &= ~_BV(PORTC5); // SCL low
-    _delay_us(5); // For 100 KHz clock
-    PORTC |= _BV(PORTC5); // SCL high
-    _delay_us(5); // For 100 KHz clock
-    if (PORTC & _BV(PORTC4))
-    {
-      // Read back a one
-      --recoveryPhase;
-    }
-    else
-    {
-      // Read back a zero, recovery not done
-      recoveryPhase = MIN_NR_RECOVERY_BITS;
-    }
+    device->stats.transactions++;
+    device->stats.bytes += position;
+    if (status != I2C_OK)
+      device->stats.errors++;
   }
-  
-  Init_I2C();
 }
 
-static _Bool _doStart( const uint8_t addr) 
-{  
+static void __countFailure(uint8_t status)
+{
+  if (!device)
+    return;
+    
+  switch(status)
+  {
+    case I2C_NACK_ADDR:
+    case I2C_NACK_DATA:
+      device->stats.nacks++;
+      break;
+    case I2C_TIMEOUT:
+      device->stats.timeouts++;
+      break;
+    default:
+      device->stats.busErrors++;
+      break;
+  }
+}
 
-  for (uint8_t attempt = 0; attempt < I2C_RECOVERY_ATTEMPTS; ++attempt)
+static inline void __countRecovery()
+{
+  if (device)
+    device->stats.recoveries++;
+}
+
+_Bool I2C_GetStats(uint8_t addr, struct I2C_Stats *stats)
+{
+  struct I2C_Device *entry = __findDevice(addr);
+  
+  if (!entry || !entry->addr)
+    return 0;
+  
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
   {
-    // Send START
-    TWCR = _BV(TWINT)| _BV(TWSTA) | _BV(TWEN);
+    *stats = entry->stats;
+  }
+  
+  return 1;
+}
 
-    I2CWait();
+_Bool I2C_GetRecord(uint8_t age, struct I2C_Record *record)
+{
+  if (age >= I2C_HISTORY_SIZE)
+    return 0;
+  
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    uint8_t idx = historyHead + I2C_HISTORY_SIZE - 1 - age;
+    
+    if (idx >= I2C_HISTORY_SIZE)
+      idx -= I2C_HISTORY_SIZE;
+    
+    *record = history[idx];
+  }
+  
+  return record->addr != 0;
+}
 
-    if ((TWSR & 0xF8) == 0x08) 
+void I2C_ClearStats()
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    for (uint8_t i = 0; i < I2C_MAX_DEVICES; ++i)
+      memset(&devices[i].stats, 0, sizeof(struct I2C_Stats));
+    
+    memset(history, 0, sizeof(history));
+    historyHead = 0;
+  }
+}
+#else
+static inline void __startClock() { }
+static inline void __clockTick(_Bool stalled) { }
+static inline void __record(struct I2C_Transaction *t, uint8_t status) { }
+static inline void __countFailure(uint8_t status) { }
+static inline void __countRecovery() { }
+#endif
+
+// Abort a transaction when the bus makes no progress for this long.
+#define I2C_TIMEOUT_US 2000 // A byte takes 90 us at 100 KHz
+
+static volatile uint8_t progress; // Incremented on every bus event
+
+// A STOP goes out within a few SCL periods (10 us at 100 KHz), unless a slave
+// holds SCL low, which the bus recovery deals with. This is also called from 
+// the TWI ISR and with interrupts disabled, so it must not wait long.
+#define I2C_STOP_TIMEOUT_US 50
+
+// Wait on STOP to clear, or reset the TWI module if it doesn't.
+static void __waitStop()
+{
+  for (uint8_t us = 0; (TWCR & _BV(TWSTO)); ++us)
+  {
+    if (us == I2C_STOP_TIMEOUT_US)
     {
+      TWCR = 0;
+      Init_I2C();
       break;
     }
-    
-    _recovery();
+    _delay_us(1);
   }
+}
+
+// (Re)start the transaction at the head of the queue, optionally sending a STOP first.
+static void __begin(_Bool stop)
+{
+  position = 0;
+  segment = 0;
+  offset = 0;
+  started = 0;
+  regSent = 0;
+  progress++;
+  __clockTick(0);
+  TWCR = (stop ? _BV(TWSTO) : 0) | _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+}
+
+static void __beginNext(_Bool stop)
+{
+  uint8_t twbr = I2C_DEFAULT_TWBR;
+  uint8_t twps = 0;
+  
+  device = __claimDevice(queueHead->addr);
+  retriesLeft = I2C_DEFAULT_RETRIES;
+  
+  if (device)
+  {
+    retriesLeft = device->retries;
+    twbr = device->twbr;
+    twps = device->twps;
+  }
+  
+  if (TWBR != twbr || (TWSR & 0x03) != twps)
+  {
+    // Changing speed. The STOP of the previous transaction must go out at the
+    // old speed, so it cannot be combined with the next START.
+    if (stop)
+    {
+      TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN);
+      __waitStop();
+      stop = 0;
+    }
     
-  TWDR= addr;  // Slave address
+    TWBR = twbr;
+    TWSR = twps;
+  }
+  
+  startAttempts = 0;
+  __startClock();
+  __begin(stop);
+}
 
-  TWCR = _BV(TWEN) | _BV(TWINT);
-  I2CWait();
+static inline void __resume(_Bool ack)
+{
+  TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE) | (ack ? _BV(TWEA) : 0);
+}
 
-  if (addr & 1)
+static void __finish(uint8_t status, _Bool stop)
+{
+  struct I2C_Transaction *t = queueHead;
+  
+  __record(t, status);
+  
+  queueHead = t->next;
+  
+  if (queueHead)
   {
-    if ((TWSR & 0xf8) != 0x40)
-      return 0;
+    __beginNext(stop); // Stop, immediately followed by a start for the next one
   }
   else
   {
-    if ((TWSR & 0xf8) != 0x18)
-      return 0;
+    queueTail = 0;
+    if (stop)
+      TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN);
   }
   
-  return 1;
+  t->status = status;
+  
+  if (t->callback)
+    t->callback(t);
 }
 
-static _Bool _Write_I2C_Bulk(uint8_t amount, const uint8_t *ptr)
+static void __fail(uint8_t status, _Bool stop)
 {
-  while(amount--)
+  __countFailure(status);
+  
+  if (retriesLeft)
   {
-    TWDR = *ptr++;
-    TWCR = _BV(TWEN) | _BV(TWINT) | _BV(TWEA); // Clear TWINT to resume,
-    I2CWait();
-    if((TWSR & 0xf8) != 0x28)
-      return 0;
+    --retriesLeft;
+    __begin(stop);
   }
+  else
+  {
+    __finish(status, stop);
+  }
+}
+
+// Bus recovery. A slave that lost track of the transfer may hold SDA low, 
+// waiting for clock pulses to finish the byte it thinks is in progress. With
+// the TWI module disabled, SCL is pulsed until SDA is seen high for 
+// MIN_NR_RECOVERY_BITS consecutive pulses, followed by a STOP. Both lines are
+// driven open-drain. The steps are paced by timer 2 compare B (which must run
+// with a /1024 prescaler), so recovery doesn't block; it gives up after 
+// I2C_MAX_RECOVERY_PULSES pulses.
+
+#define MIN_NR_RECOVERY_BITS 9  // 8 data bits + ack.
+#define I2C_MAX_RECOVERY_PULSES 32
+
+#define SDA _BV(PORTC4)
+#define SCL _BV(PORTC5)
+
+enum recoveryStates
+{
+  recoverySample,   // SCL is high: sample SDA, then pull SCL low
+  recoveryRelease,  // Release SCL
+  recoveryStopLow,  // STOP: pull SCL and SDA low
+  recoveryStopSCL,  // Release SCL
+  recoveryStopSDA,  // Release SDA
+};
+
+static uint8_t recoveryState;
+static uint8_t recoveryPulses;
+static uint8_t recoveryOnes;
+static uint8_t recoveryCause; // I2C_TIMEOUT, or I2C_BUS_ERROR for a failed START
+static volatile uint8_t recoveryStatus = I2C_RECOVERY_NONE;
+
+static inline void __release(uint8_t line)
+{
+  DDRC &= ~line;
+  PORTC |= line; // Pull-up
+}
+
+static inline void __pullLow(uint8_t line)
+{
+  PORTC &= ~line;
+  DDRC |= line;
+}
+
+static void __scheduleRecoveryStep()
+{
+  OCR2B = TCNT2 + 2; // 64 - 128 us from now
+  TIFR2 = _BV(OCF2B);
+}
+
+static void __startRecovery(uint8_t cause)
+{
+  TWCR = 0; // Disable the TWI module, releasing the bus
+  __release(SDA | SCL);
   
-  return 1;
+  recoveryCause = cause;
+  recoveryState = recoverySample;
+  recoveryPulses = 0;
+  recoveryOnes = 0;
+  recoveryStatus = I2C_RECOVERY_BUSY;
+  
+  __countRecovery();
+  __scheduleRecoveryStep();
+  TIMSK2 |= _BV(OCIE2B);
 }
 
-static _Bool _Read_I2C_Bulk(uint8_t amount, uint8_t *ptr)
+static void __endRecovery(uint8_t status)
 {
-  while(--amount)
+  TIMSK2 &= ~_BV(OCIE2B);
+  recoveryStatus = status;
+  Init_I2C();
+  
+  if (status != I2C_RECOVERY_OK)
   {
-    TWCR = _BV(TWEN) | _BV(TWINT) | _BV(TWEA); // Clear TWINT to resume, send ack to indicate more data is requested
-    I2CWait();
-    if((TWSR & 0xf8) != 0x50)
-      return 0; // not acked
+    __countFailure(I2C_BUS_ERROR);
+    __finish(I2C_BUS_ERROR, 0);
+  }
+  else if (recoveryCause == I2C_BUS_ERROR)
+    __begin(0); // Try to send the START again
+  else
+    __fail(recoveryCause, 0); // Retry, or give up
+}
 
-    *ptr++ = TWDR;
+static void __recoveryStep()
+{
+  progress++; // Keeps the timeouts at bay
+  __clockTick(0);
+  
+  switch(recoveryState)
+  {
+    case recoverySample:
+    {
+      uint8_t pins = PINC;
+      
+      if ((pins & SCL) && (pins & SDA))
+        recoveryOnes++;
+      else
+        recoveryOnes = 0;
+      
+      if (recoveryOnes >= MIN_NR_RECOVERY_BITS)
+      {
+        recoveryState = recoveryStopLow;
+      }
+      else if (++recoveryPulses > I2C_MAX_RECOVERY_PULSES)
+      {
+        __endRecovery(I2C_RECOVERY_FAILED);
+        return;
+      }
+      else
+      {
+        __pullLow(SCL);
+        recoveryState = recoveryRelease;
+      }
+      break;
+    }
+      
+    case recoveryRelease:
+      __release(SCL);
+      recoveryState = recoverySample;
+      break;
+    
+    case recoveryStopLow:
+      __pullLow(SCL);
+      __pullLow(SDA);
+      recoveryState = recoveryStopSCL;
+      break;
+      
+    case recoveryStopSCL:
+      __release(SCL);
+      recoveryState = recoveryStopSDA;
+      break;
+      
+    case recoveryStopSDA:
+      __release(SDA);
+      __endRecovery(I2C_RECOVERY_OK);
+      return;
   }
+  
+  __scheduleRecoveryStep();
+}
 
-  //read last byte
+ISR(TIMER2_COMPB_vect)
+{
+  __recoveryStep();
+}
 
-  TWCR = _BV(TWEN) | _BV(TWINT); // Clear TWINT to resume, send nack 
-  I2CWait();
-  *ptr++ = TWDR;
+uint8_t I2C_GetRecoveryStatus()
+{
+  return recoveryStatus;
+}
 
-  return 1;
+// The bus is stuck. Recover it, after which the current transaction is retried
+// or fails. Must be called with interrupts disabled.
+static void __timeout()
+{
+  __startRecovery(I2C_TIMEOUT);
 }
 
-_Bool Write_I2C_Regs(uint8_t addr, uint8_t reg, uint8_t amount, const uint8_t *ptr)
+// Load the next byte of a write into TWDR. Returns 0 if there is none.
+static _Bool __nextByte(struct I2C_Transaction *t)
 {
-  if (amount == 0)
+  if (!(t->flags & I2C_VECTOR))
+  {
+    if (position == t->amount)
+      return 0;
+    
+    TWDR = t->ptr[position++];
     return 1;
+  }
+  
+  for (; segment < t->amount; ++segment, offset = 0)
+  {
+    const struct I2C_Buffer *buffer = &t->vector[segment];
     
-  _Bool success = _doStart(addr & 0xfe);
+    if (offset < buffer->amount)
+    {
+      TWDR = buffer->ptr[offset++];
+      position++;
+      return 1;
+    }
+  }
+  
+  return 0;
+}
+
+// Advance the state machine. Must be called with interrupts disabled, or
+// from the interrupt handler.
+static void __step()
+{
+  struct I2C_Transaction *t = queueHead;
   
-  if (success)
+  progress++;
+  __clockTick(0);
+  
+  switch(TWSR & 0xf8)
   {
-    // Send register address
+    case 0x08: // START sent
+      started = 1;
+      if ((t->flags & (I2C_READ | I2C_NO_REG)) == (I2C_READ | I2C_NO_REG))
+        TWDR = t->addr | 0x01;  // Slave address, read
+      else
+        TWDR = t->addr & 0xfe;  // Slave address, write
+      __resume(0);
+      break;
+      
+    case 0x10: // Repeated START sent
+      TWDR = t->addr | 0x01;  // Slave address, read
+      __resume(0);
+      break;
+      
+    case 0x18: // SLA+W acked
+    case 0x28: // Data acked
+      if (!(t->flags & I2C_NO_REG) && !regSent)
+      {
+        TWDR = t->reg;
+        regSent = 1;
+        __resume(0);
+      }
+      else if (t->flags & I2C_READ)
+      {
+        // Register address sent, send repeated start
+        TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+      }
+      else if (__nextByte(t))
+      {
+        __resume(0);
+      }
+      else
+      {
+        __finish(I2C_OK, 1);
+      }
+      break;
+      
+    case 0x40: // SLA+R acked. Ack incoming data, unless only one byte is requested
+      __resume(t->amount > 1);
+      break;
+      
+    case 0x50: // Data received, ack sent. Nack the last byte.
+      t->ptr[position++] = TWDR;
+      __resume(position < t->amount - 1);
+      break;
+      
+    case 0x58: // Last byte received, nack sent
+      t->ptr[position++] = TWDR;
+      __finish(I2C_OK, 1);
+      break;
+    
+    case 0x20: // SLA+W not acked
+    case 0x48: // SLA+R not acked
+      __fail(I2C_NACK_ADDR, 1);
+      break;
+      
+    case 0x30: // Data not acked
+      __fail(I2C_NACK_DATA, 1);
+      break;
+      
+    default:
+      if (!started && ++startAttempts < I2C_RECOVERY_ATTEMPTS)
+      {
+        // Start request could not be sent, recover the bus and try again.
+        __startRecovery(I2C_BUS_ERROR);
+      }
+      else
+      {
+        __fail(I2C_BUS_ERROR, 1); // Arbitration lost, or bus error.
+      }
+      break;
+  }
+}
 
-    TWDR = reg;
-    TWCR = _BV(TWEN) | _BV(TWINT);
-    I2CWait();
+ISR(TWI_vect)
+{
+  __step();
+}
 
-    if ((TWSR & 0xf8) == 0x28)
-    {      
-      success = _Write_I2C_Bulk(amount, ptr);
+void I2C_Submit(struct I2C_Transaction *t)
+{
+  t->status = I2C_PENDING;
+  t->next = 0;
+  
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    if (queueTail)
+    {
+      queueTail->next = t;
+      queueTail = t;
+    }
+    else
+    {
+      queueHead = queueTail = t;
+      
+      __waitStop(); // Previous transaction
+      __beginNext(0);
     }
   }
-
-  TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN); // Stop    
-  // Wait on STOP to clear
-  while ((TWCR & _BV(TWSTO)))
-    ;
-  return success;
 }
 
-_Bool Write_I2C_Raw(uint8_t addr, uint8_t amount, const uint8_t *ptr)
+uint8_t I2C_Wait(struct I2C_Transaction *t)
 {
-  if (amount == 0)
-    return 1;
-    
-  _Bool success = _doStart(addr & 0xfe);
+  uint8_t lastProgress = progress;
+  uint16_t stalled = 0; // us
   
-  if (success)
+  while (t->status == I2C_PENDING)
   {
-    success = _Write_I2C_Bulk(amount, ptr);
+    // If interrupts are disabled (during startup) the state machines have to
+    // be driven by hand.
+    if (!(SREG & _BV(SREG_I)))
+    {
+      if (TWCR & _BV(TWINT))
+      {
+        __step();
+      }
+      else if ((TIMSK2 & _BV(OCIE2B)) && (TIFR2 & _BV(OCF2B)))
+      {
+        TIFR2 = _BV(OCF2B);
+        __recoveryStep();
+      }
+    }
+    
+    if (progress != lastProgress)
+    {
+      lastProgress = progress;
+      stalled = 0;
+    }
+    else if (++stalled == I2C_TIMEOUT_US)
+    {
+      ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+      {
+        if (progress == lastProgress) // Could have changed just now
+          __timeout();
+      }
+    }
+    else
+    {
+      _delay_us(1);
+    }
   }
   
-  TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN); // Stop    
-  // Wait on STOP to clear
-  while ((TWCR & _BV(TWSTO)))
-    ;
-  return success;
+  __waitStop();
+  
+  return t->status;
 }
 
-_Bool Read_I2C_Regs(uint8_t addr, uint8_t reg, uint8_t amount, uint8_t *ptr)
+_Bool I2C_Busy()
 {
-  if (amount == 0)
-    return 0;
+  return queueHead != 0;
+}
 
-  _Bool success = _doStart(addr & 0xfe); // slave, write in order to send register
+void I2C_Tick()
+{
+  static uint8_t lastProgress;
   
-  if (!success) 
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
   {
-    goto error;
+    if (queueHead && progress == lastProgress)
+    {
+      __clockTick(1);
+      __timeout();
+    }
+    
+    lastProgress = progress;
   }
+}
+
+static uint8_t __transfer(uint8_t addr, uint8_t reg, uint8_t flags, uint8_t amount, uint8_t *ptr)
+{
+  struct I2C_Transaction t;
   
-  success = 0; // Until proven otherwise
+  t.addr = addr;
+  t.reg = reg;
+  t.flags = flags;
+  t.amount = amount;
+  t.ptr = ptr;
+  t.callback = 0;
   
-  // Send register address
-
-  TWDR = reg;
-  TWCR = _BV(TWEN) | _BV(TWINT);
-  I2CWait();
-
-  if ((TWSR & 0xf8) != 0x28)
-    goto error; // Not ack.
-
-  // Send repeated start
-  TWCR = _BV(TWINT)| _BV(TWSTA) | _BV(TWEN);
-  I2CWait();
+  I2C_Submit(&t);
+  
+  return I2C_Wait(&t);
+}
 
-  if ((TWSR & 0xF8) != 0x10)
-    goto error;
+uint8_t Write_I2C_Regs(uint8_t addr, uint8_t reg, uint8_t amount, const uint8_t *ptr)
+{
+  if (amount == 0)
+    return I2C_OK;
+    
+  return __transfer(addr, reg, 0, amount, (uint8_t *) ptr);
+}
 
-  TWDR=addr | 0x01;  // Slave address, read
-  TWCR = _BV(TWEN) | _BV(TWINT);
-  I2CWait();
+uint8_t Write_I2C_Raw(uint8_t addr, uint8_t amount, const uint8_t *ptr)
+{
+  if (amount == 0)
+    return I2C_OK;
+  
+  return __transfer(addr, 0, I2C_NO_REG, amount, (uint8_t *) ptr);
+}
 
-  if ((TWSR & 0xf8) != 0x40)
-    goto error; // Not acked
+uint8_t Write_I2C_RegsV(uint8_t addr, uint8_t reg, const struct I2C_Buffer *buffers, uint8_t count)
+{
+  struct I2C_Transaction t;
+  
+  t.addr = addr;
+  t.reg = reg;
+  t.flags = I2C_VECTOR;
+  t.amount = count;
+  t.vector = buffers;
+  t.callback = 0;
   
-  success = _Read_I2C_Bulk(amount, ptr);
+  I2C_Submit(&t);
   
-error:
-  TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN); // Stop    
-  // Wait on STOP to clear
-  while ((TWCR & _BV(TWSTO)))
-    ;
-  return success;
+  return I2C_Wait(&t);
 }
 
-_Bool Read_I2C_Raw(uint8_t addr, uint8_t amount, uint8_t *ptr)
+uint8_t Read_I2C_Regs(uint8_t addr, uint8_t reg, uint8_t amount, uint8_t *ptr)
 {
   if (amount == 0)
-    return 0;
+    return I2C_NACK_DATA; // Nothing to read
 
-  _Bool success = _doStart(addr | 1 );
-  
-  if (success) // slave, read
-  {
-    success = _Read_I2C_Bulk(amount, ptr);
-  }
-  
-  TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN); // Stop    
-  // Wait on STOP to clear
-  while ((TWCR & _BV(TWSTO)))
-    ;
-  return success;
+  return __transfer(addr, reg, I2C_READ, amount, ptr);
+}
+
+uint8_t Read_I2C_Raw(uint8_t addr, uint8_t amount, uint8_t *ptr)
+{
+  if (amount == 0)
+    return I2C_NACK_DATA; // Nothing to read
+
+  return __transfer(addr, 0, I2C_READ | I2C_NO_REG, amount, ptr);
 }
 
 void Init_I2C()
@@ -259,6 +787,6 @@ void Init_I2C()
   
   // Configure I2C speed: 100 KHz @ 16MHz clock
   TWSR = 0;
-  TWBR = 72;
+  TWBR = I2C_DEFAULT_TWBR;
   TWCR = _BV(TWEN); // enable I2C
 }
@@ -18,10 +18,131 @@ PERFORMANCE OF THIS SOFTWARE.
 
 #include <inttypes.h>
 
+enum I2C_Status
+{
+  I2C_OK,
+  I2C_NACK_ADDR,  // Slave did not acknowledge its address
+  I2C_NACK_DATA,  // Slave did not acknowledge a data byte
+  I2C_BUS_ERROR,  // START could not be sent, arbitration was lost, or bus recovery failed
+  I2C_TIMEOUT,    // The bus made no progress for I2C_TIMEOUT_US
+  I2C_PENDING,    // Queued or in progress
+  I2C_IDLE,       // Never submitted
+};
+
+// Transaction flags
+#define I2C_READ   0x01 // Read from the slave, rather than write to it
+#define I2C_NO_REG 0x02 // Don't send a register address first
+#define I2C_VECTOR 0x04 // Write: gather the data from 'vector', 'amount' buffers
+
+// One of the buffers of a vectored write
+struct I2C_Buffer
+{
+  const uint8_t *ptr;
+  uint8_t amount;
+};
+
+struct I2C_Transaction;
+typedef void (*I2C_Callback)(struct I2C_Transaction *);
+
+// A transaction is owned by the caller, and must stay valid (together with the 
+// buffer(s) it points to) until it has completed. 
+struct I2C_Transaction
+{
+  uint8_t addr;   // Slave address, the R/W bit is ignored
+  uint8_t reg;    // Register address, unless I2C_NO_REG is set
+  uint8_t flags;
+  uint8_t amount; // Reads must transfer at least one byte
+  union
+  {
+    uint8_t *ptr;
+    const struct I2C_Buffer *vector; // If I2C_VECTOR is set
+  };
+  I2C_Callback callback; // Called from interrupt context on completion, may be 0
+  volatile uint8_t status; // enum I2C_Status
+  struct I2C_Transaction *next; // Used by the queue
+};
+
 void Init_I2C();
-_Bool Read_I2C_Regs(uint8_t addr, uint8_t reg, uint8_t amount, uint8_t *ptr);
-_Bool Read_I2C_Raw(uint8_t addr, uint8_t amount, uint8_t *ptr);
-_Bool Write_I2C_Regs(uint8_t addr, uint8_t reg, uint8_t amount, const uint8_t *ptr);
-_Bool Write_I2C_Raw(uint8_t addr, uint8_t amount, const uint8_t *ptr);
+
+// Number of times a failed transaction to this slave is retried before its
+// error is reported. Slaves that were not configured use I2C_DEFAULT_RETRIES.
+void I2C_SetRetries(uint8_t addr, uint8_t retries);
+
+// TWBR value for a bus speed in KHz, with TWPS = 0 (prescaler 1). Valid from 
+// about 31 KHz upwards at 16 MHz.
+#define I2C_TWBR(khz) ((F_CPU / 1000UL / (khz) - 16) / 2)
+
+// Bus speed used for transactions to this slave. Slaves that were not configured, and
+// retries after a bus reset, run at 100 KHz.
+void I2C_SetSpeed(uint8_t addr, uint8_t twbr, uint8_t twps);
+
+// Queue a transaction. Returns immediately, the TWI interrupt runs the transfer.
+void I2C_Submit(struct I2C_Transaction *t);
+
+// Block until the transaction has completed, and return its status.
+uint8_t I2C_Wait(struct I2C_Transaction *t);
+
+// True while transactions are queued or in progress.
+_Bool I2C_Busy();
+
+// Abort the transaction on the bus if it made no progress since the previous
+// call. Call periodically, this catches stalled background transactions.
+void I2C_Tick();
+
+enum I2C_RecoveryStatus
+{
+  I2C_RECOVERY_NONE,
+  I2C_RECOVERY_BUSY,
+  I2C_RECOVERY_OK,
+  I2C_RECOVERY_FAILED, // SDA still low after I2C_MAX_RECOVERY_PULSES clock pulses
+};
+
+// Outcome of the last bus recovery. Recovery runs in the background (on timer 2
+// compare B) when a START fails, or a transaction times out; the transaction 
+// is retried afterwards.
+uint8_t I2C_GetRecoveryStatus();
+
+#ifdef I2C_TELEMETRY
+// Bus statistics, kept per slave address
+struct I2C_Stats
+{
+  uint16_t transactions;
+  uint16_t errors;      // Transactions that failed, after all retries
+  uint16_t nacks;       // Including the ones that were retried
+  uint16_t timeouts;    // Idem
+  uint16_t busErrors;   // Idem
+  uint16_t recoveries;  // Bus recovery attempts
+  uint32_t bytes;       // Data bytes transferred
+};
+
+// Record of a completed transaction
+struct I2C_Record
+{
+  uint8_t addr;   // 0 if unused
+  uint8_t amount; // Data bytes transferred
+  uint8_t status; // enum I2C_Status
+  uint8_t ticks;  // Duration including retries, in timer 2 ticks of 64 us. 255 means 16 ms or more.
+};
+
+#define I2C_HISTORY_SIZE 8
+
+// Copy the statistics of a slave. Returns 0 if it was never addressed.
+_Bool I2C_GetStats(uint8_t addr, struct I2C_Stats *stats);
+
+// Copy one of the last I2C_HISTORY_SIZE transactions; age 0 is the most recent.
+// Returns 0 if there is no such transaction.
+_Bool I2C_GetRecord(uint8_t age, struct I2C_Record *record);
+
+void I2C_ClearStats();
+#endif
+
+// Blocking API, implemented on top of the queue. These return an enum I2C_Status.
+uint8_t Read_I2C_Regs(uint8_t addr, uint8_t reg, uint8_t amount, uint8_t *ptr);
+uint8_t Read_I2C_Raw(uint8_t addr, uint8_t amount, uint8_t *ptr);
+uint8_t Write_I2C_Regs(uint8_t addr, uint8_t reg, uint8_t amount, const uint8_t *ptr);
+uint8_t Write_I2C_Raw(uint8_t addr, uint8_t amount, const uint8_t *ptr);
+
+// Write several buffers to consecutive registers, in one transaction.
+uint8_t Write_I2C_RegsV(uint8_t addr, uint8_t reg, const struct I2C_Buffer *buffers, uint8_t count);
 #endif
 
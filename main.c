@@ -92,6 +92,7 @@ enum clockMode
 } ;
 
 volatile uint16_t event ;
+volatile uint8_t sqwSeconds = 0; // SQW periods not yet handled by the main loop
 
 uint8_t timer2_scaler = 2;
 
@@ -103,8 +104,12 @@ ISR (TIMER2_OVF_vect)
   // First 3 array members are the debounce queue
   // Last array member is the reported button state
   
-  // Add new data
-  buttonDebounce[timer2_scaler] = PIND;
+  // Add new data. PD2 is the SQW input, handled by INT0.
+  buttonDebounce[timer2_scaler] = PIND | _BV(PIND2);
+  
+  // Re-arm INT0 once SQW is high again
+  if (!(EIMSK & _BV(INT0)) && (PIND & _BV(PIND2)))
+    EIMSK |= _BV(INT0);
   
   // Handle beeping here, so timing is strict
   if (beepIsOn)
@@ -163,11 +168,46 @@ ISR (TIMER2_OVF_vect)
   }
 }
 
+// Falling edge of the DS1307 square wave. Edge detection needs the I/O clock,
+// which is stopped in power save mode, so use the low level interrupt and
+// disable it until timer 2 sees the line going high again.
+ISR (INT0_vect)
+{
+  EIMSK &= ~(_BV(INT0));
+  sqwSeconds++;
+  event |= CLOCK_UPDATE;
+}
+
 ISR (TIMER0_COMPA_vect)
 {
   PINC = _BV(PORTC1); // Toggle output
 }
 
+volatile _Bool renderTick = 0;
+
+ISR (TIMER1_COMPA_vect)
+{
+  renderTick = 1; // RENDERER_FPS times per second, while running
+}
+
+// The render clock only runs while the display is animating, so there are
+// no wakeups for it otherwise.
+static void UpdateRenderClock()
+{
+  if (!Renderer_IsAnimating())
+  {
+    TCCR1B = _BV(WGM12); // Stop timer
+    TIMSK1 = 0;
+  }
+  else if (!(TIMSK1 & _BV(OCIE1A)))
+  {
+    TCNT1 = 0;
+    TIFR1 = _BV(OCF1A);
+    TIMSK1 = _BV(OCIE1A);
+    TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10); // CTC, /64 prescaler
+  }
+}
+
 static inline _Bool IsPastAlarmTime(const struct AlarmSetting *alarm, const struct DateTime *timestamp)
 {
   return (timestamp->hour > alarm->hour) || (timestamp->hour == alarm->hour && timestamp->min >= alarm->min);
@@ -273,10 +313,7 @@ _Bool RadioOn()
   SI4702_SetFrequency(TheGlobalSettings.radio.frequency);
   SI4702_SetVolume(TheGlobalSettings.radio.volume);
   
-  Poll_SI4702();
-  // Amplifier control is active low
-  
-  PORTC = PORTC & ~( _BV(PORTC2)); 
+  // The radio starts in the background, the amplifier is enabled once it is up.
   radioIsOn = 1;  
   return 1;
 }
@@ -379,6 +416,49 @@ void SilenceAlarms()
   }
 }
 
+static inline _Bool IsRadioAlarmAt(const struct AlarmSetting *alarm, enum enumAlarmScheduleState scheduled, uint16_t minute)
+{
+  return scheduled == SCHEDULED && (alarm->flags & ALARM_TYPE_RADIO) && 
+         BCDToBin(alarm->hour) * 60 + BCDToBin(alarm->min) == minute;
+}
+
+// Warm up the radio in the minute before a radio alarm, so it starts right away.
+void PrepareRadioAlarms()
+{
+  uint16_t nextMinute = BCDToBin(TheDateTime.hour) * 60 + BCDToBin(TheDateTime.min) + 1;
+  if (nextMinute == 24 * 60)
+    nextMinute = 0;
+  
+  if (IsRadioAlarmAt(&TheGlobalSettings.alarm1, alarm1Scheduled, nextMinute) ||
+      IsRadioAlarmAt(&TheGlobalSettings.alarm2, alarm2Scheduled, nextMinute) ||
+      IsRadioAlarmAt(&TheGlobalSettings.onetime_alarm, onetimeAlarmScheduled, nextMinute))
+    SI4702_Standby();
+}
+
+// The radio failed to start in the background; sound the beeper instead if it was for an alarm.
+enum clockMode RadioFailed()
+{
+  RadioOff();
+  
+  switch (TheDeviceState.deviceMode)
+  {
+    case modeAlarmFiring_radio:
+      BeepOn();
+      if (alarm1Timeout)
+        alarm1Timeout = ALARM_BEEP_TIMEOUT;
+      if (alarm2Timeout)
+        alarm2Timeout = ALARM_BEEP_TIMEOUT;
+      if (onetimeAlarmTimeout)
+        onetimeAlarmTimeout = ALARM_BEEP_TIMEOUT;
+      return modeAlarmFiring_beep;
+    case modeShowRadio:
+    case modeShowRadio_Volume:
+      return modeShowTime;
+    default:
+      return TheDeviceState.deviceMode;
+  }
+}
+
 enum clockMode ActivateAlarms()
 {
   enum clockMode newDeviceMode = TheDeviceState.deviceMode;
@@ -505,34 +585,20 @@ void ApplyTimeAdjust()
 
   TheDeviceState.timeAdjustRemainder += TheGlobalSettings.time_adjust;
 
-  if (TheDeviceState.timeAdjustRemainder >= 10)
+  while(TheDeviceState.timeAdjustRemainder >= 10)
   {
-    while(TheDeviceState.timeAdjustRemainder >= 10)
-    {
-      ++adjust;
-      TheDeviceState.timeAdjustRemainder -= 10;
-    }
-
-    if (adjust >= 10)
-      adjust += 6;
-
-    TheDateTime.sec = BCDAdd(TheDateTime.sec, adjust);
-    Write_DS1307_DateTime();
+    ++adjust;
+    TheDeviceState.timeAdjustRemainder -= 10;
   }
-  else if (TheDeviceState.timeAdjustRemainder <= -10)
-  {
-    while(TheDeviceState.timeAdjustRemainder <= -10)
-    {
-      ++adjust;
-      TheDeviceState.timeAdjustRemainder += 10;
-    }
 
-    if (adjust >= 10)
-      adjust += 6;
-
-    TheDateTime.sec = BCDSub(TheDateTime.sec, adjust);
-    Write_DS1307_DateTime();
+  while(TheDeviceState.timeAdjustRemainder <= -10)
+  {
+    --adjust;
+    TheDeviceState.timeAdjustRemainder += 10;
   }
+
+  if (adjust)
+    Adjust_DS1307_DateTime(adjust);
 }
 
 int main(void)
@@ -547,7 +613,11 @@ int main(void)
   
   wdt_reset();
   
-  InitializePanels(4);
+  InitializePanels();
+  
+  // Start timer 2: /1024 prescaler. Its interrupts are enabled later on, but
+  // I2C bus recovery already depends on it running.
+  TCCR2B = _BV(CS22) | _BV(CS21) | _BV(CS20); 
   
   Init_I2C();
   Init_DS1307();
@@ -586,10 +656,10 @@ int main(void)
   DDRD = 0;
   PORTD = ~(_BV(PORTD2));
 
-  TIMSK2 = _BV(TOIE2); // Enable overflow interrupt, will trigger every 16 ms
+  TIMSK2 |= _BV(TOIE2); // Enable overflow interrupt, will trigger every 16 ms
   
-  // Setup timer 2: /1024 prescaler, 
-  TCCR2B = _BV(CS22) | _BV(CS21) | _BV(CS20); 
+  EICRA = 0; // INT0 on low level of SQW
+  EIMSK = _BV(INT0);
 
   // Setup beeper timer.
   TCCR0A = _BV(WGM01); // CTC mode.  
@@ -597,6 +667,11 @@ int main(void)
   OCR0A = 78; // To be used with a /64 clock scaler
   TIMSK0 = _BV(OCIE0A); // Enable output match interrupt
   
+  // Setup render timer: CTC mode, started by UpdateRenderClock()
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12);
+  OCR1A = (F_CPU / 64 / RENDERER_FPS) - 1;
+  
   uint8_t secMode = SECONDARY_MODE_SEC;
   uint8_t mainMode = MAIN_MODE_TIME;
 
@@ -633,10 +708,16 @@ int main(void)
   
     _Bool updateScreen = 0;
     uint16_t acceptedEvents = 0;
+    _Bool frameDue = 0;
+    uint8_t seconds = 0;
     ATOMIC_BLOCK(ATOMIC_FORCEON)
     {
       acceptedEvents = event;
       event = 0;
+      seconds = sqwSeconds;
+      sqwSeconds = 0;
+      frameDue = renderTick;
+      renderTick = 0;
     }
     
     GetLongPress(acceptedEvents, &longPressEvent);
@@ -645,6 +726,17 @@ int main(void)
       
     enum clockMode newDeviceMode = TheDeviceState.deviceMode;
 
+    if ((clockEvents & CLOCK_TICK) && SI4702_Step())
+    {
+      // Radio finished starting or stopping
+      if (radioIsOn && SI4702_GetState() == SI4702_ON)
+        PORTC = PORTC & ~( _BV(PORTC2)); // Amplifier control is active low
+      else if (radioIsOn && SI4702_GetState() == SI4702_FAILED)
+        newDeviceMode = RadioFailed();
+      
+      Renderer_Update_Secondary();
+    }
+    
     if (clockEvents & CLOCK_UPDATE)
     {
       if (writeSettingTimeout)
@@ -661,9 +753,13 @@ int main(void)
          newDeviceMode = (radioIsOn?modeShowRadio : modeShowTime) ;
       }
     
-      if (timePollAllowed)
+      if (!timePollAllowed)
+      {
+        Invalidate_DS1307_DateTime(); // Being edited
+      }
+      else
       {
-        Read_DS1307_DateTime();
+        Update_DS1307_DateTime(seconds);
         
         updateScreen = 1;
 
@@ -687,6 +783,7 @@ int main(void)
           SilenceAlarms();
 
           newDeviceMode = ActivateAlarms();
+          PrepareRadioAlarms();
           
           SetBrightness(GetActiveBrightness(&TheDateTime));
         }        
@@ -1397,24 +1494,38 @@ int main(void)
       Renderer_Update_Main(mainMode, (clockEvents & CLOCK_UPDATE) && (TheDeviceState.deviceMode == modeShowTime ) );
     }
 
+    if (radioIsOn && ((clockEvents & CLOCK_TICK) || SI4702_Signalled()) && 
+        Poll_SI4702() && TheDeviceState.deviceMode == modeShowRadio)
+    {
+      // Radio is done seeking or tuning
+      Renderer_Update_Secondary();
+      TheGlobalSettings.radio.frequency = SI4702_GetFrequency();
+      writeSettingTimeout = 5;
+    }
+    
     if (clockEvents & CLOCK_TICK)
     {
-      if (radioIsOn && Poll_SI4702() && TheDeviceState.deviceMode == modeShowRadio)
+      I2C_Tick(); // Catch stalled background transfers
+      
+      if (Panels_Resync())
       {
-        // Radio is done seeking or tuning
-        Renderer_Update_Secondary();
-        TheGlobalSettings.radio.frequency = SI4702_GetFrequency();
-        writeSettingTimeout = 5;
+        // Panels were reconfigured, re-send all pixel data as well
+        Renderer_Redraw();
       }
-      
-      Renderer_Tick(secMode);
     }
+    
+    if (frameDue)
+      Renderer_Tick(secMode);
+    else if (clockEvents)
+      Renderer_Render(secMode);
+    
+    UpdateRenderClock();
    
-    if (clockEvents == 0 && buttonEvents == 0)
+    if (clockEvents == 0 && buttonEvents == 0 && !SI4702_Signalled())
     {
       // Nothing to do, go to sleep
-      if (beepIsOn)
-        set_sleep_mode(SLEEP_MODE_IDLE); // keep timer 0 running!
+      if (beepIsOn || Panels_Busy() || I2C_Busy() || Renderer_IsAnimating())
+        set_sleep_mode(SLEEP_MODE_IDLE); // keep timers 0 and 1, SPI and TWI running!
       else
         set_sleep_mode(SLEEP_MODE_PWR_SAVE);
       cli();
@@ -0,0 +1,108 @@
+--[[
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+--]]
+
+-- Generates the 7-segment glyph table, already transposed to the row wiring
+-- of the adapter board. Usage: lua mksegment.lua segment.txt header|source
+
+local segmentfile = io.open(arg[1], "r")
+if not segmentfile then error ("Unable to open ".. arg[1]) end
+
+local mode = arg[2]
+if mode ~= "header" and mode ~= "source" then error ("Specify either header or source") end
+
+local lineIter = segmentfile:lines()
+
+-- First line lists the segment connected to each row, first row first.
+local wiring = { }
+local rowOfSegment = { }
+
+for segment in string.gmatch(lineIter(), "%S+") do
+  if segment ~= "wiring" then
+    table.insert(wiring, segment)
+    rowOfSegment[segment] = #wiring - 1
+  end
+end
+
+if #wiring ~= 8 then error ("Wiring should list 8 rows") end
+
+-- Remaining lines: glyph name, followed by the lit segments ('-' for none)
+local glyphs = { }
+
+for line in lineIter do
+  local name, segments = string.match(line, "^(%S+)%s+(%S+)")
+  if name then
+    local rows = { }
+    for row = 1, 8 do rows[row] = "0x00" end
+    
+    for segment in string.gmatch(segments, "[a-g]") do
+      rows[rowOfSegment[segment] + 1] = "0xff"
+    end
+    
+    table.insert(glyphs, { name = name, rows = rows, segments = segments })
+  end
+end
+
+local license = [[
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+]]
+
+print (license)
+
+if mode == "header" then
+  print ("#ifndef __SEGMENT_H__")
+  print ("#define __SEGMENT_H__")
+  print ""
+  print ("#include <avr/pgmspace.h>")
+  print ("#include <stdint.h>")
+  print ""
+  
+  for idx, glyph in ipairs(glyphs) do
+    print ("#define GLYPH_" .. glyph.name .. " " .. (idx - 1))
+  end
+  
+  print ""
+  print ("#define SEGMENT_ROW_DP " .. rowOfSegment["dp"])
+  print ""
+  print ("// One byte per row: 0xff if the segment wired to that row is lit")
+  print ("extern const uint8_t PROGMEM SegmentGlyphs[][8];")
+  print ""
+  print ("#endif")
+else
+  print ("#include <segment.h>")
+  print ""
+  print ("// Rows: " .. table.concat(wiring, " "))
+  print ("const uint8_t PROGMEM SegmentGlyphs[][8] = {")
+  
+  for idx, glyph in ipairs(glyphs) do
+    print ("  { " .. table.concat(glyph.rows, ", ") .. " }, // [" .. (idx - 1) .. "] " .. glyph.name .. ": " .. glyph.segments)
+  end
+  
+  print ("};")
+end
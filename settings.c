@@ -52,8 +52,15 @@ _Bool ReadGlobalSettings()
 void WriteGlobalSettings()
 {
   uint8_t checksum = CalculateCRC();
-  Write_DS1307_RAM(&checksum, 0, 1);
-  Write_DS1307_RAM((uint8_t *) &TheGlobalSettings, 1, sizeof(struct GlobalSettings));
+  
+  // Checksum at offset 0, settings at offset 1: one transaction, so they cannot disagree.
+  const struct I2C_Buffer buffers[2] = 
+  {
+    { &checksum, 1 },
+    { (const uint8_t *) &TheGlobalSettings, sizeof(struct GlobalSettings) },
+  };
+  
+  Write_DS1307_RAMV(buffers, 2, 0);
 }
 
 uint8_t GetActiveBrightness(const struct DateTime *timestamp)
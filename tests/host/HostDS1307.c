@@ -0,0 +1,132 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+// DS1307 model: 8 clock registers and 56 bytes of NVRAM behind a register
+// pointer that wraps around at 63.
+#include "HostI2C.h"
+
+#define CH   0x80 // Clock halt, in the seconds register
+#define OUT  0x80 // Control register
+#define SQWE 0x10
+#define RS_BITS 0x03
+
+uint8_t HostDS1307_Regs[64];
+
+static uint8_t pointer = 0;
+static _Bool pointerNext = 0; // First byte of a write sets the pointer
+static uint16_t subSecond = 0; // ms
+
+static void __start(_Bool read)
+{
+  pointerNext = !read;
+}
+
+static _Bool __write(uint8_t data)
+{
+  if (pointerNext)
+  {
+    pointer = data & 0x3f;
+    pointerNext = 0;
+    return 1;
+  }
+  
+  if (pointer == 0)
+    subSecond = 0; // Writing the seconds resets the countdown chain
+  
+  HostDS1307_Regs[pointer] = data;
+  pointer = (pointer + 1) & 0x3f;
+  return 1;
+}
+
+static uint8_t __read()
+{
+  uint8_t data = HostDS1307_Regs[pointer];
+  
+  pointer = (pointer + 1) & 0x3f;
+  return data;
+}
+
+const struct HostI2CDevice HostDS1307 = { 0xd0, __start, __write, __read, 0 };
+
+// Increment a BCD register. Returns 1 when it wraps around from 'last' to 'first'.
+static _Bool __increment(uint8_t *reg, uint8_t mask, uint8_t first, uint8_t last)
+{
+  uint8_t value = *reg & mask;
+  
+  if (value == last)
+  {
+    *reg = (*reg & ~mask) | first;
+    return 1;
+  }
+  
+  if ((value & 0x0f) == 9)
+    value += 6;
+  
+  *reg = (*reg & ~mask) | (value + 1);
+  return 0;
+}
+
+static uint8_t __lastDay()
+{
+  static const uint8_t days[12] = { 0x31, 0x28, 0x31, 0x30, 0x31, 0x30, 0x31, 0x31, 0x30, 0x31, 0x30, 0x31 };
+  uint8_t month = HostDS1307_Regs[5] & 0x1f;
+  uint8_t year = HostDS1307_Regs[6];
+  
+  month = (month >> 4) * 10 + (month & 0x0f);
+  year = (year >> 4) * 10 + (year & 0x0f);
+  
+  if (month == 2 && (year % 4) == 0)
+    return 0x29;
+  
+  return days[month - 1];
+}
+
+static void __tick()
+{
+  uint8_t *regs = HostDS1307_Regs;
+  
+  if (!__increment(&regs[0], 0x7f, 0x00, 0x59) ||
+      !__increment(&regs[1], 0x7f, 0x00, 0x59) ||
+      !__increment(&regs[2], 0x3f, 0x00, 0x23))
+    return;
+  
+  __increment(&regs[3], 0x07, 0x01, 0x07);
+  
+  if (__increment(&regs[4], 0x3f, 0x01, __lastDay()) &&
+      __increment(&regs[5], 0x1f, 0x01, 0x12))
+    __increment(&regs[6], 0xff, 0x00, 0x99);
+}
+
+void HostDS1307_Advance(uint16_t ms)
+{
+  if (HostDS1307_Regs[0] & CH)
+    return; // Oscillator stopped
+  
+  for (subSecond += ms; subSecond >= 1000; subSecond -= 1000)
+    __tick();
+}
+
+_Bool HostDS1307_SQW()
+{
+  uint8_t control = HostDS1307_Regs[7];
+  
+  if (!(control & SQWE))
+    return (control & OUT) != 0;
+  
+  if ((HostDS1307_Regs[0] & CH) || (control & RS_BITS))
+    return 0; // Stopped, or faster than modelled
+  
+  return subSecond < 500; // 1 Hz, rising edge when the seconds increment
+}
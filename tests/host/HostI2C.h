@@ -0,0 +1,65 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+#ifndef __HOSTI2C_H__
+#define __HOSTI2C_H__
+
+#include <stdint.h>
+
+// A slave on the simulated bus. The callbacks are made as the TWI puts the 
+// corresponding condition on the bus.
+struct HostI2CDevice
+{
+  uint8_t addr; // R/W bit clear
+  void (*start)(_Bool read); // Addressed after a (repeated) START
+  _Bool (*write)(uint8_t data); // Returns the ack bit
+  uint8_t (*read)();
+  void (*stop)();
+};
+
+// Simulated TWI peripheral and bus (HostTWI.c)
+void HostTWI_Reset();
+void HostTWI_Attach(const struct HostI2CDevice *device);
+
+// Run the TWI and bus recovery interrupt handlers for as long as they are 
+// pending, which completes queued background transactions.
+void HostTWI_Run();
+
+extern _Bool HostTWI_Stuck;       // When set, the bus never completes anything
+extern uint16_t HostTWI_SDAHeld;  // A slave holds SDA low for this many more SCL pulses
+extern uint32_t HostTWI_Bytes;    // Bytes clocked over the bus, including addresses
+extern uint32_t HostTWI_Starts;   // START conditions, not counting repeated ones
+extern uint64_t HostClock_ns;     // Simulated time: bus time plus delays
+
+void HostClock_Advance(double us);
+
+// DS1307 model (HostDS1307.c): time registers, control register and 56 bytes
+// of NVRAM. Only 24 hour mode is modelled, the square wave only at 1 Hz.
+extern const struct HostI2CDevice HostDS1307;
+extern uint8_t HostDS1307_Regs[64];
+
+void HostDS1307_Advance(uint16_t ms);
+_Bool HostDS1307_SQW(); // Level of the SQW/OUT pin
+
+// SI4702 model (HostSI4702.c). Stations are in .1 MHz, the RSSI in dBuV.
+extern const struct HostI2CDevice HostSI4702;
+extern uint16_t HostSI4702_Regs[16];
+
+void HostSI4702_Reset();
+void HostSI4702_AddStation(uint16_t frequency, uint8_t rssi);
+// RDS groups (blocks A - D each) sent in turn, on any station
+void HostSI4702_SetRDS(const uint16_t *groups, uint8_t count);
+
+#endif
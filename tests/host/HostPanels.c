@@ -0,0 +1,77 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+// Stand-in for Panels.c on the host: captures everything sent to the panels.
+#include <string.h>
+#include "HostPanels.h"
+
+uint8_t HostPanels_Frame[FRAME_SIZE];
+uint32_t HostPanels_Rows, HostPanels_Bytes;
+uint8_t HostPanels_Brightness = 4, HostPanels_Fade = 16;
+
+void HostPanels_Reset()
+{
+  memset(HostPanels_Frame, 0, sizeof(HostPanels_Frame));
+  HostPanels_Rows = HostPanels_Bytes = 0;
+}
+
+void InitializePanels()
+{
+  HostPanels_Reset();
+}
+
+void SetBrightness(uint8_t level)
+{
+  HostPanels_Brightness = level;
+}
+
+void SetFade(uint8_t level)
+{
+  HostPanels_Fade = level;
+}
+
+_Bool Panels_Resync()
+{
+  return 0;
+}
+
+_Bool Panels_Busy()
+{
+  return 0;
+}
+
+void SendRow(uint8_t row, const uint8_t *data, uint8_t panelMask)
+{
+  panelMask &= (1 << PANEL_COUNT) - 1;
+  
+  if (!panelMask)
+    return;
+  
+  // Like Panels.c, the chain is cut short after the last panel to update
+  // (assuming the panels beyond it hold no-ops). 2 bytes per panel.
+  uint8_t chainLength = PANEL_COUNT;
+  
+  while (!(panelMask & (1 << (chainLength - 1))))
+    --chainLength;
+  
+  ++HostPanels_Rows;
+  HostPanels_Bytes += 2 * chainLength;
+  
+  for (uint8_t x = 0; x < PANEL_COUNT; ++x)
+  {
+    if (panelMask & (1 << x))
+      HostPanels_Frame[row * PANEL_COUNT + x] = data[x];
+  }
+}
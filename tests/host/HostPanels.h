@@ -0,0 +1,34 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+#ifndef __HOSTPANELS_H__
+#define __HOSTPANELS_H__
+
+#include <stdint.h>
+#include "Panels.h"
+
+// Contents of the panels, as captured from SendRow(). Row-major, 
+// PANEL_COUNT bytes per row.
+extern uint8_t HostPanels_Frame[FRAME_SIZE];
+
+// Number of SendRow() calls, and SPI bytes they would have clocked out
+extern uint32_t HostPanels_Rows;
+extern uint32_t HostPanels_Bytes;
+
+extern uint8_t HostPanels_Brightness, HostPanels_Fade;
+
+void HostPanels_Reset();
+
+#endif
@@ -0,0 +1,334 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+// SI4702 model. Reads start at register 0x0A and wrap around from 0x0F to 
+// 0x00, writes start at register 2 (see SI4702.c). Tuning takes 60 ms, seeking
+// 20 ms per channel visited; RSSI and stereo follow the station list. RDS 
+// groups repeat every 87.6 ms, and are flagged ready for 40 ms. With STCIEN set
+// and GPIO2 configured as interrupt, GPIO2 (PB0) is pulled low for 5 ms when 
+// a seek or tune completes. RDS interrupts are not modelled.
+#include <avr/io.h>
+#include "HostI2C.h"
+
+#define MAX_STATIONS 8
+
+#define POWERCFG   0x02
+  #define SKMODE   0x0400
+  #define SEEKUP   0x0200
+  #define SEEK     0x0100
+  #define DISABLE  0x0040
+  #define ENABLE   0x0001
+  #define MONO     0x2000
+#define CHANNEL    0x03
+  #define TUNE     0x8000
+#define SYSCONFIG1 0x04
+  #define STCIEN   0x4000
+  #define RDSEN    0x1000
+  #define GPIO2    0x000c
+  #define GPIO2_INT 0x0004
+#define SYSCONFIG2 0x05
+#define STATUSRSSI 0x0A
+  #define STC      0x4000
+  #define SFBL     0x2000
+  #define RDSR     0x8000
+  #define RDSS     0x0800
+  #define ST       0x0100
+#define READCHAN   0x0B
+#define RDSA       0x0C
+
+#define CHAN_BITS  0x03ff
+
+#define TUNE_TIME_NS 60000000ULL
+#define SEEK_STEP_NS 20000000ULL
+#define RDS_GROUP_NS 87600000ULL
+#define RDS_READY_NS 40000000ULL
+#define GPIO2_LOW_NS 5000000ULL
+
+uint8_t DDRB, PORTB, PCMSK0, PCICR;
+
+uint16_t HostSI4702_Regs[16];
+
+static struct
+{
+  uint16_t frequency;
+  uint8_t rssi;
+} stations[MAX_STATIONS];
+static uint8_t nrStations;
+
+static uint8_t reg;
+static _Bool highByte;
+static uint8_t writeLatch;
+static _Bool written; // Registers were written in this transfer
+
+static _Bool busy;
+static uint64_t busyUntil;
+static uint16_t targetChannel;
+static _Bool seekFailed;
+static _Bool gpio2Pulse;
+static uint64_t gpio2Low; // Start of the GPIO2 pulse
+
+static const uint16_t *rdsGroups;
+static uint8_t nrRdsGroups;
+static uint64_t rdsStart;
+
+void HostSI4702_Reset()
+{
+  for (uint8_t i = 0; i < 16; ++i)
+    HostSI4702_Regs[i] = 0;
+  
+  HostSI4702_Regs[0] = 0x1242; // Device ID
+  HostSI4702_Regs[1] = 0x1253; // Chip ID
+  HostSI4702_Regs[7] = 0x0100; // TEST1 reset value
+  
+  nrStations = 0;
+  nrRdsGroups = 0;
+  busy = 0;
+  gpio2Pulse = 0;
+}
+
+void HostSI4702_SetRDS(const uint16_t *groups, uint8_t count)
+{
+  rdsGroups = groups;
+  nrRdsGroups = count;
+  rdsStart = HostClock_ns;
+}
+
+void HostSI4702_AddStation(uint16_t frequency, uint8_t rssi)
+{
+  if (nrStations < MAX_STATIONS)
+  {
+    stations[nrStations].frequency = frequency;
+    stations[nrStations].rssi = rssi;
+    nrStations++;
+  }
+}
+
+// Band start and channel spacing, in 10 KHz units
+static uint16_t __bandStart()
+{
+  return (HostSI4702_Regs[SYSCONFIG2] & 0xc0) ? 7600 : 8750;
+}
+
+static uint16_t __bandEnd()
+{
+  return ((HostSI4702_Regs[SYSCONFIG2] & 0xc0) == 0x80) ? 9000 : 10800;
+}
+
+static uint8_t __spacing()
+{
+  switch (HostSI4702_Regs[SYSCONFIG2] & 0x30)
+  {
+    case 0x00: return 20;
+    case 0x10: return 10;
+    default:   return 5;
+  }
+}
+
+static uint16_t __lastChannel()
+{
+  return (__bandEnd() - __bandStart()) / __spacing();
+}
+
+static uint8_t __rssi(uint16_t channel)
+{
+  uint16_t frequency = __bandStart() + channel * __spacing();
+  
+  for (uint8_t i = 0; i < nrStations; ++i)
+  {
+    if (stations[i].frequency * 10 == frequency)
+      return stations[i].rssi;
+  }
+  
+  return 5; // Noise
+}
+
+static void __startSeek()
+{
+  uint16_t channel = HostSI4702_Regs[READCHAN] & CHAN_BITS;
+  uint16_t start = channel;
+  uint8_t threshold = HostSI4702_Regs[SYSCONFIG2] >> 8;
+  _Bool up = HostSI4702_Regs[POWERCFG] & SEEKUP;
+  uint16_t steps = 0;
+  
+  seekFailed = 1;
+  
+  do
+  {
+    ++steps;
+    
+    if (up ? channel == __lastChannel() : channel == 0)
+    {
+      if (HostSI4702_Regs[POWERCFG] & SKMODE)
+        break; // Stop at the band limit
+      channel = up ? 0 : __lastChannel();
+    }
+    else
+    {
+      channel += up ? 1 : -1;
+    }
+    
+    if (__rssi(channel) >= threshold)
+    {
+      seekFailed = 0;
+      break;
+    }
+  } while (channel != start);
+  
+  targetChannel = channel;
+  busy = 1;
+  busyUntil = HostClock_ns + steps * SEEK_STEP_NS;
+}
+
+// The host wrote new register values
+static void __apply()
+{
+  uint16_t *regs = HostSI4702_Regs;
+  
+  if (!(regs[CHANNEL] & TUNE) && !(regs[POWERCFG] & SEEK))
+  {
+    busy = 0;
+    regs[STATUSRSSI] &= ~(STC | SFBL);
+    return;
+  }
+  
+  if (busy || (regs[STATUSRSSI] & STC) || !(regs[POWERCFG] & ENABLE) || (regs[POWERCFG] & DISABLE))
+    return;
+  
+  if (regs[POWERCFG] & SEEK)
+  {
+    __startSeek();
+  }
+  else
+  {
+    targetChannel = regs[CHANNEL] & CHAN_BITS;
+    seekFailed = 0;
+    busy = 1;
+    busyUntil = HostClock_ns + TUNE_TIME_NS;
+  }
+}
+
+// Finish a seek or tune once its time has passed
+static void __complete()
+{
+  uint16_t *regs = HostSI4702_Regs;
+  
+  if (!busy || HostClock_ns < busyUntil)
+    return;
+  
+  busy = 0;
+  regs[READCHAN] = (regs[READCHAN] & ~CHAN_BITS) | targetChannel;
+  regs[STATUSRSSI] |= STC | (seekFailed ? SFBL : 0);
+  rdsStart = HostClock_ns; // Synchronize again
+  
+  if ((regs[SYSCONFIG1] & STCIEN) && (regs[SYSCONFIG1] & GPIO2) == GPIO2_INT)
+  {
+    gpio2Pulse = 1;
+    gpio2Low = busyUntil;
+  }
+}
+
+uint8_t HostSI4702_PinB()
+{
+  __complete();
+  
+  if (gpio2Pulse && HostClock_ns < gpio2Low + GPIO2_LOW_NS)
+    return 0xff & ~_BV(PINB0);
+  
+  gpio2Pulse = 0;
+  return 0xff;
+}
+
+static void __update()
+{
+  uint16_t *regs = HostSI4702_Regs;
+  
+  __complete();
+  
+  uint8_t rssi = __rssi(regs[READCHAN] & CHAN_BITS);
+  
+  regs[STATUSRSSI] &= ~(ST | 0xff);
+  regs[STATUSRSSI] |= rssi;
+  if (rssi >= 30 && !(regs[POWERCFG] & MONO))
+    regs[STATUSRSSI] |= ST;
+  
+  // No block errors, so the BLER bits stay 0 in verbose mode as well
+  regs[STATUSRSSI] &= ~(RDSR | RDSS);
+  if (nrRdsGroups && !busy && (regs[SYSCONFIG1] & RDSEN) && (regs[POWERCFG] & ENABLE) && !(regs[POWERCFG] & DISABLE))
+  {
+    uint64_t elapsed = HostClock_ns - rdsStart;
+    const uint16_t *group = rdsGroups + 4 * ((elapsed / RDS_GROUP_NS) % nrRdsGroups);
+    
+    for (uint8_t i = 0; i < 4; ++i)
+      regs[RDSA + i] = group[i];
+    
+    regs[STATUSRSSI] |= RDSS;
+    if (elapsed % RDS_GROUP_NS < RDS_READY_NS)
+      regs[STATUSRSSI] |= RDSR;
+  }
+}
+
+static void __start(_Bool read)
+{
+  reg = read ? STATUSRSSI : POWERCFG;
+  highByte = 1;
+  
+  if (read)
+    __update();
+}
+
+static _Bool __write(uint8_t data)
+{
+  if (highByte)
+  {
+    writeLatch = data;
+  }
+  else
+  {
+    if (reg >= POWERCFG && reg <= 0x09) // The others are read-only
+      HostSI4702_Regs[reg] = (writeLatch << 8) | data;
+    written = 1;
+    reg = (reg + 1) & 0x0f;
+  }
+  
+  highByte = !highByte;
+  return 1;
+}
+
+static uint8_t __read()
+{
+  uint8_t data;
+  
+  if (highByte)
+  {
+    data = HostSI4702_Regs[reg] >> 8;
+  }
+  else
+  {
+    data = HostSI4702_Regs[reg] & 0xff;
+    reg = (reg + 1) & 0x0f;
+  }
+  
+  highByte = !highByte;
+  return data;
+}
+
+static void __stop()
+{
+  if (written)
+    __apply();
+  written = 0;
+}
+
+const struct HostI2CDevice HostSI4702 = { 0x20, __start, __write, __read, __stop };
@@ -0,0 +1,41 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+// Globals and radio calls the renderer uses, normally provided by main.c,
+// settings.c and SI4702.c.
+#include <stdint.h>
+#include "DateTime.h"
+#include "settings.h"
+#include "SI4702.h"
+
+struct DateTime TheDateTime;
+uint8_t TheSleepTime = 0;
+uint8_t TheNapTime = 0;
+
+struct GlobalSettings TheGlobalSettings;
+
+uint8_t HostStubs_Volume = 0;
+
+uint8_t SI4702_GetVolume()
+{
+  return HostStubs_Volume;
+}
+
+enum SI4702_State HostStubs_RadioState = SI4702_ON;
+
+enum SI4702_State SI4702_GetState()
+{
+  return HostStubs_RadioState;
+}
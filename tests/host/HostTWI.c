@@ -0,0 +1,278 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+// Simulated TWI peripheral for the host build of i2c.c. A write to TWCR is
+// acted upon when TWCR is accessed next: every access goes through 
+// HostTWI_Control(), and bit 1 (which is unused by the hardware) marks that
+// the current value has been dealt with. Every operation completes at once, 
+// and advances the simulated clock by the time it would take on the bus.
+// TIFR2 uses the same scheme, with bit 7 as marker.
+#include <stdio.h>
+#include <avr/io.h>
+#include "HostI2C.h"
+
+#define HANDLED 0x02
+#define MAX_DEVICES 4
+
+uint8_t TWSR, TWBR, TWDR;
+uint8_t DDRC, PORTC;
+uint8_t TCNT2, OCR2B, TIMSK2;
+uint8_t SREG = 0;
+
+_Bool HostTWI_Stuck = 0;
+uint16_t HostTWI_SDAHeld = 0;
+uint32_t HostTWI_Bytes = 0;
+uint32_t HostTWI_Starts = 0;
+uint64_t HostClock_ns = 0;
+
+static uint8_t twcr = HANDLED;
+static uint8_t tifr2 = 0x80;
+static uint8_t timerFlags = 0;
+static _Bool interruptFlag = 0;
+
+static const struct HostI2CDevice *devices[MAX_DEVICES];
+static uint8_t nrDevices = 0;
+
+static _Bool busOwned = 0;
+static _Bool addressNext = 0; // Next data byte is a slave address
+static _Bool reading = 0;
+static const struct HostI2CDevice *addressed = 0;
+
+void HostClock_Advance(double us)
+{
+  uint64_t before = HostClock_ns / 64000; // Timer 2 ticks are 64 us
+  
+  HostClock_ns += us * 1000;
+  
+  uint64_t after = HostClock_ns / 64000;
+  uint8_t toCompare = OCR2B - (uint8_t) before;
+  
+  if (after - before >= 256 || (toCompare != 0 && toCompare <= after - before))
+    timerFlags |= _BV(OCF2B);
+  
+  TCNT2 = after;
+}
+
+uint8_t *HostTimer2_Flags()
+{
+  if (!(tifr2 & 0x80))
+    timerFlags &= ~tifr2; // Written
+  
+  tifr2 = timerFlags | 0x80;
+  return &tifr2;
+}
+
+uint8_t HostTWI_Pins()
+{
+  uint8_t pins = 0;
+  
+  if (!(DDRC & _BV(PORTC5)) || (PORTC & _BV(PORTC5)))
+    pins |= _BV(PORTC5);
+  
+  if (!(DDRC & _BV(PORTC4)) || (PORTC & _BV(PORTC4)))
+    pins |= _BV(PORTC4);
+  
+  if (HostTWI_SDAHeld)
+  {
+    pins &= ~_BV(PORTC4);
+    if (pins & _BV(PORTC5))
+      HostTWI_SDAHeld--; // Released after this many clock pulses
+  }
+  
+  return pins;
+}
+
+static void __busTime(uint8_t bits)
+{
+  // SCL = F_CPU / (16 + 2 * TWBR * 4^TWPS)
+  uint32_t cycles = 16 + 2 * TWBR * (1 << (2 * (TWSR & 0x03)));
+  
+  HostClock_Advance(bits * cycles / 16.0);
+}
+
+void HostTWI_Reset()
+{
+  nrDevices = 0;
+  twcr = HANDLED;
+  interruptFlag = busOwned = addressNext = 0;
+  addressed = 0;
+  HostTWI_Stuck = 0;
+  HostTWI_SDAHeld = 0;
+  HostTWI_Bytes = 0;
+  HostTWI_Starts = 0;
+}
+
+void HostTWI_Attach(const struct HostI2CDevice *device)
+{
+  if (nrDevices < MAX_DEVICES)
+    devices[nrDevices++] = device;
+}
+
+static void __status(uint8_t status)
+{
+  TWSR = status | (TWSR & 0x03);
+  interruptFlag = 1;
+}
+
+static void __stop()
+{
+  if (addressed && addressed->stop)
+    addressed->stop();
+  
+  addressed = 0;
+  busOwned = 0;
+  __busTime(1);
+}
+
+static void __start()
+{
+  __status(busOwned ? 0x10 : 0x08);
+  
+  if (!busOwned)
+    HostTWI_Starts++;
+  
+  if (addressed && addressed->stop)
+    addressed->stop(); // Repeated start ends the previous transfer as well
+  addressed = 0;
+  busOwned = 1;
+  addressNext = 1;
+  __busTime(1);
+}
+
+static void __address()
+{
+  reading = TWDR & 0x01;
+  addressNext = 0;
+  addressed = 0;
+  
+  for (uint8_t i = 0; i < nrDevices; ++i)
+  {
+    if (devices[i]->addr == (TWDR & 0xfe))
+      addressed = devices[i];
+  }
+  
+  if (addressed)
+  {
+    addressed->start(reading);
+    __status(reading ? 0x40 : 0x18);
+  }
+  else
+  {
+    __status(reading ? 0x48 : 0x20);
+  }
+}
+
+static void __transfer(uint8_t command)
+{
+  HostTWI_Bytes++;
+  __busTime(9);
+  
+  if (!busOwned)
+  {
+    __status(0x00); // Bus error
+  }
+  else if (addressNext)
+  {
+    __address();
+  }
+  else if (!addressed)
+  {
+    __status(reading ? 0x58 : 0x30); // Nobody listening
+  }
+  else if (reading)
+  {
+    TWDR = addressed->read();
+    __status((command & _BV(TWEA)) ? 0x50 : 0x58);
+  }
+  else
+  {
+    __status(addressed->write(TWDR) ? 0x28 : 0x30);
+  }
+}
+
+static void __execute(uint8_t command)
+{
+  if (!(command & _BV(TWEN)))
+  {
+    // Module disabled, releases the bus
+    addressed = 0;
+    busOwned = 0;
+    interruptFlag = 0;
+    return;
+  }
+  
+  if (!(command & _BV(TWINT)))
+    return; // Nothing to do
+  
+  interruptFlag = 0;
+  
+  if (HostTWI_Stuck || HostTWI_SDAHeld)
+    return; // Nothing will ever happen
+  
+  if (command & _BV(TWSTO))
+    __stop();
+  
+  if (command & _BV(TWSTA))
+    __start();
+  else if (!(command & _BV(TWSTO)))
+    __transfer(command);
+}
+
+uint8_t *HostTWI_Control()
+{
+  if (!(twcr & HANDLED))
+  {
+    __execute(twcr);
+    twcr &= ~(_BV(TWINT) | _BV(TWSTO));
+  }
+  else if (!(twcr & _BV(TWEN)))
+  {
+    __execute(twcr); // Disabled by a read-modify-write
+  }
+  
+  twcr = (twcr & ~_BV(TWINT)) | (interruptFlag ? _BV(TWINT) : 0) | HANDLED;
+  
+  return &twcr;
+}
+
+void TWI_vect(void);
+void TIMER2_COMPB_vect(void);
+
+void HostTWI_Run()
+{
+  while (1)
+  {
+    if ((TWCR & _BV(TWIE)) && (TWCR & _BV(TWINT)))
+    {
+      TWI_vect();
+    }
+    else if (TIMSK2 & _BV(OCIE2B)) // Bus recovery
+    {
+      if (TIFR2 & _BV(OCF2B))
+      {
+        TIFR2 = _BV(OCF2B);
+        TIMER2_COMPB_vect();
+      }
+      else
+      {
+        HostClock_Advance(64);
+      }
+    }
+    else
+    {
+      break;
+    }
+  }
+}
@@ -0,0 +1,73 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+// Host build: the I/O registers the I2C drivers use. The TWI is simulated by
+// HostTWI.c, see there.
+#ifndef __HOST_IO_H__
+#define __HOST_IO_H__
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+// Reading or writing TWCR first lets the simulated TWI act on the previous write.
+uint8_t *HostTWI_Control();
+#define TWCR (*HostTWI_Control())
+
+extern uint8_t TWSR, TWBR, TWDR;
+extern uint8_t DDRC, PORTC;
+extern uint8_t TCNT2, OCR2B, TIMSK2;
+
+// SDA and SCL follow DDRC and PORTC (open drain, pulled up), and the slaves.
+uint8_t HostTWI_Pins();
+#define PINC (HostTWI_Pins())
+
+// Timer 2 compare flags are set as the simulated clock passes OCR2B, and
+// cleared by writing a one.
+uint8_t *HostTimer2_Flags();
+#define TIFR2 (*HostTimer2_Flags())
+extern uint8_t SREG; // Interrupts stay disabled, the state machine is driven by hand
+
+// PB0 is the SI4702 GPIO2 line, driven by HostSI4702.c. The pin change 
+// interrupt is raised by the test itself.
+extern uint8_t DDRB, PORTB, PCMSK0, PCICR;
+uint8_t HostSI4702_PinB();
+#define PINB (HostSI4702_PinB())
+
+#define TWINT 7
+#define TWEA  6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC  3
+#define TWEN  2
+#define TWIE  0
+
+#define PORTC3 3
+#define PORTC4 4
+#define PORTC5 5
+
+#define PORTB0 0
+#define PINB0  0
+
+#define PCINT0 0
+#define PCIE0  0
+
+#define SREG_I 7
+
+#define TOIE2  0
+#define OCIE2B 2
+#define OCF2B  2
+
+#endif
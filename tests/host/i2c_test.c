@@ -0,0 +1,589 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+// Runs the DS1307 and SI4702 drivers, and the settings, against the simulated
+// I2C bus, and reports the bus time they take.
+#include <stdio.h>
+#include <string.h>
+#include <avr/io.h>
+#include "HostI2C.h"
+#include "i2c.h"
+#include "DS1307.h"
+#include "SI4702.h"
+#include "settings.h"
+#include "DateTime.h"
+#include "Timefuncs.h"
+#include "RDS.h"
+
+#define SI4702_ADDR 0x20
+
+struct DateTime TheDateTime;
+
+extern uint8_t SI4702_regs[32];
+
+static _Bool errorOccurred = 0;
+
+static void Check(const char *what, _Bool ok)
+{
+  if (!ok)
+  {
+    fprintf(stderr, "FAIL: %s\n", what);
+    errorOccurred = 1;
+  }
+}
+
+#ifdef I2C_TELEMETRY
+static struct I2C_Stats Stats(uint8_t addr)
+{
+  struct I2C_Stats stats;
+  memset(&stats, 0, sizeof(stats));
+  I2C_GetStats(addr, &stats);
+  return stats;
+}
+
+static struct I2C_Record LastRecord()
+{
+  struct I2C_Record record;
+  memset(&record, 0, sizeof(record));
+  I2C_GetRecord(0, &record);
+  return record;
+}
+#endif
+
+static void Test_DS1307()
+{
+  // 2019-01-15 10:20:30 UTC, a tuesday; clock halted and in 12 hour mode
+  static const uint8_t utc[7] = { 0x80 | 0x30, 0x20, 0x40 | 0x10, 2, 0x15, 0x01, 0x19 };
+  
+  memcpy(HostDS1307_Regs, utc, sizeof(utc));
+  
+  Init_DS1307();
+  
+  Check("DS1307: oscillator enabled", !(HostDS1307_Regs[0] & 0x80));
+  Check("DS1307: 24 hour mode", !(HostDS1307_Regs[2] & 0x40));
+  Check("DS1307: 1 Hz square wave", HostDS1307_Regs[7] == 0x10);
+  
+  HostDS1307_Advance(2000);
+#ifdef I2C_TELEMETRY
+  I2C_ClearStats();
+#endif
+  Read_DS1307_DateTime();
+#ifdef I2C_TELEMETRY
+  struct I2C_Stats stats = Stats(0xd0);
+  struct I2C_Record record = LastRecord();
+  Check("Telemetry: DS1307 read counted", stats.transactions == 1 && stats.bytes == 7 && stats.errors == 0 && stats.nacks == 0);
+  Check("Telemetry: DS1307 read recorded", record.addr == 0xd0 && record.amount == 7 && record.status == I2C_OK && 
+        record.ticks >= 10 && record.ticks <= 20); // 0.93 ms
+#endif
+  
+  Check("DS1307: time read back, in CET", TheDateTime.hour == 0x11 && TheDateTime.min == 0x20 && TheDateTime.sec == 0x32);
+  Check("DS1307: date read back", TheDateTime.day == 0x15 && TheDateTime.month == 0x01 && TheDateTime.year == 0x19);
+  
+  // One rising edge of SQW per second
+  uint8_t edges = 0;
+  _Bool level = HostDS1307_SQW();
+  
+  for (uint16_t ms = 0; ms < 3000; ms += 50)
+  {
+    HostDS1307_Advance(50);
+    if (HostDS1307_SQW() && !level)
+      edges++;
+    level = HostDS1307_SQW();
+  }
+  
+  Check("DS1307: SQW at 1 Hz", edges == 3);
+  
+  // Year rollover
+  static const uint8_t newYear[7] = { 0x59, 0x59, 0x23, 7, 0x31, 0x12, 0x19 };
+  memcpy(HostDS1307_Regs, newYear, sizeof(newYear));
+  HostDS1307_Advance(1000);
+  Check("DS1307: rollover", HostDS1307_Regs[0] == 0 && HostDS1307_Regs[2] == 0 && HostDS1307_Regs[3] == 1 && 
+        HostDS1307_Regs[4] == 1 && HostDS1307_Regs[5] == 1 && HostDS1307_Regs[6] == 0x20);
+}
+
+static void Test_Clock()
+{
+  // 2019-03-31 00:00:00 UTC, two hours around the switch to summer time
+  static const uint8_t utc[7] = { 0x00, 0x00, 0x00, 7, 0x31, 0x03, 0x19 };
+  
+  memcpy(HostDS1307_Regs, utc, sizeof(utc));
+  Invalidate_DS1307_DateTime();
+  
+  uint32_t starts = HostTWI_Starts;
+  _Bool inStep = 1;
+  
+  for (uint16_t s = 0; s < 7200; ++s)
+  {
+    HostDS1307_Advance(1000);
+    Update_DS1307_DateTime(1);
+    
+    struct DateTime rtc;
+    memcpy(&rtc, HostDS1307_Regs, 7);
+    UTCToCentralEuropeanTime(&rtc);
+    
+    if (memcmp(&rtc, &TheDateTime, sizeof(rtc)) != 0)
+      inStep = 0;
+  }
+  
+  Check("Clock: follows the RTC", inStep);
+  Check("Clock: switched to summer time", TheDateTime.hour == 0x04 && TheDateTime.min == 0 && TheDateTime.sec == 0);
+  Check("Clock: RTC read once an hour", HostTWI_Starts - starts == 2);
+  
+  // Missed edges are caught up with
+  HostDS1307_Advance(3000);
+  Update_DS1307_DateTime(3);
+  Check("Clock: several seconds at once", TheDateTime.sec == 0x03);
+  
+  // Setting the time resyncs on the next edge
+  TheDateTime.min = 0x30;
+  Write_DS1307_DateTime();
+  HostDS1307_Advance(1000);
+  starts = HostTWI_Starts;
+  Update_DS1307_DateTime(1);
+  Check("Clock: resync after setting", HostTWI_Starts - starts == 1 && TheDateTime.min == 0x30 && TheDateTime.sec == 0x04);
+}
+
+static void Test_Settings()
+{
+  Check("Settings: fit in the NVRAM", sizeof(struct GlobalSettings) + 1 <= 56);
+  
+  memset(HostDS1307_Regs + 8, 0xff, 56);
+  Check("Settings: blank NVRAM rejected", !ReadGlobalSettings());
+  
+  TheGlobalSettings.radio.frequency = 1017;
+  TheGlobalSettings.radio.volume = 7;
+  TheGlobalSettings.brightness = 9;
+  TheGlobalSettings.alarm1.hour = 0x07;
+  TheGlobalSettings.alarm1.flags = ALARM_ACTIVE | ALARM_SUSPENDED;
+  TheGlobalSettings.time_adjust = -12;
+  
+  struct GlobalSettings written = TheGlobalSettings;
+  
+  uint32_t starts = HostTWI_Starts;
+  WriteGlobalSettings();
+  Check("Settings: written in one transaction", HostTWI_Starts - starts == 1);
+  
+  memset(&TheGlobalSettings, 0, sizeof(TheGlobalSettings));
+  
+  Check("Settings: read back", ReadGlobalSettings());
+  written.alarm1.flags &= ~ALARM_SUSPENDED;
+  Check("Settings: contents", memcmp(&written, &TheGlobalSettings, sizeof(written)) == 0);
+  
+  HostDS1307_Regs[8 + 3] ^= 0x01;
+  Check("Settings: corruption detected", !ReadGlobalSettings());
+}
+
+// Step the power state machine every CLOCK_TICK until it reaches 'state'
+static _Bool StepUntil(enum SI4702_State state)
+{
+  for (uint8_t tick = 0; tick < 20; ++tick)
+  {
+    SI4702_Step();
+    if (SI4702_GetState() == state)
+      return 1;
+    HostClock_Advance(48000);
+  }
+  
+  return 0;
+}
+
+#ifndef SI4702_STC_IRQ
+// Poll the radio every CLOCK_TICK (48 ms) until it reports that it is done
+static _Bool PollUntilDone()
+{
+  for (uint16_t tick = 0; tick < 500; ++tick)
+  {
+    _Bool done = Poll_SI4702();
+    
+    HostTWI_Run();
+    if (done)
+      return 1;
+    HostClock_Advance(48000);
+  }
+  
+  return 0;
+}
+
+static uint8_t RSSI()
+{
+  return SI4702_regs[1]; // STATUS_RSSI_L
+}
+
+static void Test_SI4702()
+{
+  HostSI4702_Reset();
+  HostSI4702_AddStation(943, 40);
+  HostSI4702_AddStation(1001, 50);
+  HostSI4702_AddStation(1035, 10); // Below the seek threshold
+  
+  Check("SI4702: init", Init_SI4702() && SI4702_GetState() == SI4702_OFF);
+  
+  uint64_t start = HostClock_ns;
+  Check("SI4702: power on", SI4702_PowerOn());
+  Check("SI4702: power on returns right away", HostClock_ns - start < 2000000ULL && SI4702_GetState() == SI4702_STARTING);
+  Check("SI4702: started", StepUntil(SI4702_ON));
+  Check("SI4702: oscillator settled", HostClock_ns - start >= 135000000ULL);
+  Check("SI4702: oscillator enabled", HostSI4702_Regs[7] & 0x8000);
+  
+  SI4702_SetFrequency(943);
+  Check("SI4702: tune", PollUntilDone());
+  Check("SI4702: tuned frequency", SI4702_GetFrequency() == 943);
+  Check("SI4702: tuned RSSI", RSSI() == 40);
+  
+  SI4702_Seek(1);
+  Check("SI4702: seek up", PollUntilDone());
+  Check("SI4702: found next station", SI4702_GetFrequency() == 1001 && RSSI() == 50);
+  
+  SI4702_Seek(1);
+  Check("SI4702: seek up, wrapping around", PollUntilDone());
+  Check("SI4702: skipped the weak station", SI4702_GetFrequency() == 943);
+  
+  SI4702_Seek(0);
+  Check("SI4702: seek down", PollUntilDone());
+  Check("SI4702: wrapped around downwards", SI4702_GetFrequency() == 1001);
+  
+  SI4702_Tune(1);
+  Check("SI4702: tune up", PollUntilDone());
+  Check("SI4702: next channel", SI4702_GetFrequency() == 1002 && RSSI() < 20);
+  
+  Check("SI4702: tuning bits cleared", !(HostSI4702_Regs[3] & 0x8000) && !(HostSI4702_Regs[2] & 0x0100));
+  
+  // Tuning writes registers 2 and 3 only, idle polls just read the status
+  uint32_t bytes = HostTWI_Bytes;
+  SI4702_SetFrequency(943);
+  Check("SI4702: tune again", PollUntilDone());
+  Poll_SI4702();
+  HostTWI_Run();
+  Check("SI4702: dirty registers written", HostTWI_Bytes - bytes > 13 && HostTWI_Bytes - bytes < 80);
+  
+  bytes = HostTWI_Bytes;
+  Poll_SI4702();
+  HostTWI_Run();
+  Check("SI4702: status only poll", HostTWI_Bytes - bytes == 13); // Including the RDS blocks
+  
+#ifdef I2C_TELEMETRY
+  I2C_ClearStats();
+  Poll_SI4702();
+  HostTWI_Run();
+  struct I2C_Stats stats = Stats(SI4702_ADDR);
+  struct I2C_Record record = LastRecord();
+  Check("Telemetry: SI4702 poll counted", stats.transactions == 1 && stats.bytes == 12 && stats.errors == 0);
+  Check("Telemetry: SI4702 poll recorded", record.addr == SI4702_ADDR && record.amount == 12 && record.status == I2C_OK && record.ticks <= 10);
+#endif
+  
+  SI4702_SetVolume(20);
+  Check("SI4702: volume", SI4702_GetVolume() == 20 && (HostSI4702_Regs[5] & 0x0f) == 5 && !(HostSI4702_Regs[6] & 0x0100));
+  
+  SI4702_PowerOff();
+  Check("SI4702: powered down", (HostSI4702_Regs[2] & 0x0040) && SI4702_GetState() == SI4702_STOPPING);
+  Check("SI4702: standby", StepUntil(SI4702_STANDBY) && (HostSI4702_Regs[7] & 0x8000));
+  
+  // Standby times out after a few minutes, stopping the oscillator
+  for (uint16_t tick = 0; tick < 6300 && SI4702_GetState() == SI4702_STANDBY; ++tick)
+  {
+    HostClock_Advance(48000);
+    SI4702_Step();
+  }
+  Check("SI4702: standby expired", SI4702_GetState() == SI4702_OFF && !(HostSI4702_Regs[7] & 0x8000));
+  
+  // Warming up ahead of an alarm stops at standby
+  SI4702_Standby();
+  Check("SI4702: warm up", StepUntil(SI4702_STANDBY) && (HostSI4702_Regs[7] & 0x8000));
+  
+  // Turning the radio off while it starts aborts the start, without bus traffic
+  uint32_t starts = HostTWI_Starts;
+  SI4702_PowerOn();
+  SI4702_PowerOff();
+  Check("SI4702: start aborted", SI4702_GetState() == SI4702_OFF && HostTWI_Starts == starts);
+}
+
+// RDS groups are decoded from the regular polls, without extra transfers
+static void Test_RDS()
+{
+  static const uint16_t groups[] =
+  {
+    0x8201, 0x0000, 0xe0cd, 0x5241, // 0A "RA"
+    0x8201, 0x0001, 0xe0cd, 0x4449, // 0A "DI"
+    0x8201, 0x0002, 0xe0cd, 0x4f20, // 0A "O "
+    0x8201, 0x0003, 0xe0cd, 0x3120, // 0A "1 "
+    0x8201, 0x2000, 0x4865, 0x6c6c, // 2A "Hell"
+    0x8201, 0x2001, 0x6f0d, 0x2020, // 2A "o", end
+    0x8201, 0x4001, 0xc99a, 0x1002, // 4A 2019-03-31 01:00 UTC
+  };
+  
+  SI4702_PowerOn();
+  StepUntil(SI4702_ON);
+  SI4702_SetFrequency(943);
+  PollUntilDone();
+  Poll_SI4702(); // Write out the end of the tune
+  HostTWI_Run();
+  
+  HostSI4702_SetRDS(groups, 7);
+  
+  uint32_t starts = HostTWI_Starts;
+  uint32_t bytes = HostTWI_Bytes;
+  uint32_t epoch = 0;
+  _Bool clockTime = 0;
+  
+  for (uint8_t poll = 0; poll < 100; ++poll)
+  {
+    HostClock_Advance(48000);
+    Poll_SI4702();
+    HostTWI_Run();
+    clockTime |= RDS_TakeClockTime(&epoch);
+  }
+  
+  Check("RDS: one read per poll", HostTWI_Starts - starts == 100 && HostTWI_Bytes - bytes == 100 * 13);
+  Check("RDS: station name", RDS_GetStationName() && !strcmp(RDS_GetStationName(), "RADIO 1 "));
+  Check("RDS: RadioText", RDS_GetRadioText() && !strcmp(RDS_GetRadioText(), "Hello"));
+  Check("RDS: clock time", clockTime && epoch == 607309200);
+  
+  SI4702_Seek(1);
+  PollUntilDone();
+  Check("RDS: cleared after tuning", !RDS_GetStationName() && !RDS_GetRadioText());
+  
+  HostSI4702_SetRDS(0, 0);
+}
+
+// Time from SI4702_PowerOn() until the radio is on, from off (cold) and standby (warm)
+static void Measure_Start()
+{
+  SI4702_PowerOff();
+  StepUntil(SI4702_STANDBY);
+  SI4702_PowerOn();
+  uint64_t start = HostClock_ns;
+  StepUntil(SI4702_ON);
+  double warm = (HostClock_ns - start) / 1e6;
+  
+  Init_SI4702();
+  start = HostClock_ns;
+  SI4702_PowerOn();
+  StepUntil(SI4702_ON);
+  double cold = (HostClock_ns - start) / 1e6;
+  
+  Check("SI4702: warm start is faster", warm < cold);
+  printf("Radio start: cold %.2f ms, warm %.2f ms\n", cold, warm);
+}
+
+// Bus time of one idle poll (status read-back only)
+static void Measure_Poll(const char *name)
+{
+  uint64_t start = HostClock_ns;
+  uint32_t bytes = HostTWI_Bytes;
+  
+  Poll_SI4702();
+  HostTWI_Run();
+  
+  printf("Poll_SI4702 at %s: %u bytes, %.2f ms\n", name, HostTWI_Bytes - bytes, (HostClock_ns - start) / 1e6);
+}
+
+static void Test_Throughput()
+{
+  Measure_Start();
+  Measure_Poll("400 KHz");
+  I2C_SetSpeed(SI4702_ADDR, I2C_TWBR(100), 0);
+  Measure_Poll("100 KHz");
+  I2C_SetSpeed(SI4702_ADDR, I2C_TWBR(400), 0);
+  
+  uint64_t start = HostClock_ns;
+  Read_DS1307_DateTime();
+  printf("Read_DS1307_DateTime: %.2f ms\n", (HostClock_ns - start) / 1e6);
+  
+  start = HostClock_ns;
+  ReadGlobalSettings();
+  printf("ReadGlobalSettings: %.2f ms\n", (HostClock_ns - start) / 1e6);
+}
+#else
+void PCINT0_vect(void); // SI4702.c
+
+// The pin change interrupt, raised on a change of PB0 while it is enabled
+static void PinChange()
+{
+  static uint8_t last = _BV(PINB0);
+  uint8_t pin = PINB & _BV(PINB0);
+  
+  if (pin != last && (PCICR & _BV(PCIE0)) && (PCMSK0 & _BV(PCINT0)))
+    PCINT0_vect();
+  last = pin;
+}
+
+// Run the main loop in 1 ms steps: poll every CLOCK_TICK, or right away when
+// signalled. Returns the time until the radio reported that it is done, in ms.
+static uint16_t RunUntilDone()
+{
+  for (uint16_t ms = 1; ms < 5000; ++ms)
+  {
+    HostClock_Advance(1000);
+    PinChange();
+    if (ms % 48 == 0 || SI4702_Signalled())
+    {
+      _Bool done = Poll_SI4702();
+      
+      HostTWI_Run();
+      if (done)
+        return ms;
+    }
+  }
+  
+  return 0;
+}
+
+// Seek and tune completion signalled on GPIO2, instead of polling the status
+static void Test_Signal()
+{
+  HostSI4702_Reset();
+  HostSI4702_AddStation(943, 40);
+  HostSI4702_AddStation(1001, 50);
+  
+  Check("SI4702 IRQ: init", Init_SI4702() && SI4702_GetState() == SI4702_OFF);
+  SI4702_PowerOn();
+  Check("SI4702 IRQ: started", StepUntil(SI4702_ON));
+  Check("SI4702 IRQ: GPIO2 interrupt configured", (HostSI4702_Regs[4] & 0x400c) == 0x4004);
+  Check("SI4702 IRQ: pin change enabled", (PCICR & _BV(PCIE0)) && (PCMSK0 & _BV(PCINT0)) && !(DDRB & _BV(PORTB0)));
+  
+  SI4702_SetFrequency(943);
+  Check("SI4702 IRQ: tune", RunUntilDone() && SI4702_GetFrequency() == 943);
+  Poll_SI4702(); // Write out the end of the tune
+  HostTWI_Run();
+  
+  // Write the seek, one read when signalled, and the write ending the seek
+  uint32_t starts = HostTWI_Starts;
+  uint64_t start = HostClock_ns;
+  SI4702_Seek(1);
+  uint16_t ms = RunUntilDone();
+  Poll_SI4702();
+  HostTWI_Run();
+  Check("SI4702 IRQ: seek up", ms && SI4702_GetFrequency() == 1001);
+  Check("SI4702 IRQ: no status polling", HostTWI_Starts - starts == 3);
+  // The seek is written at the first tick, and takes 58 channels of 20 ms
+  Check("SI4702 IRQ: handled right away", HostClock_ns - start <= (48 + 58 * 20 + 2) * 1000000ULL);
+  
+  starts = HostTWI_Starts;
+  for (uint8_t tick = 0; tick < 20; ++tick)
+  {
+    HostClock_Advance(48000);
+    PinChange();
+    Poll_SI4702();
+    HostTWI_Run();
+  }
+  Check("SI4702 IRQ: idle without bus traffic", HostTWI_Starts == starts && !SI4702_Signalled());
+  
+  // A write-out still queued is not queued a second time
+  SI4702_Tune(1);
+  Poll_SI4702();
+  SI4702_Tune(1);
+  Check("SI4702 IRQ: busy while writing", !Poll_SI4702());
+  HostTWI_Run();
+  Check("SI4702 IRQ: written once", HostTWI_Starts - starts == 1 && !I2C_Busy());
+  Check("SI4702 IRQ: tune up", RunUntilDone() && SI4702_GetFrequency() == 1002);
+  
+  SI4702_PowerOff();
+  Check("SI4702 IRQ: standby", StepUntil(SI4702_STANDBY));
+  Check("SI4702 IRQ: pin change masked", !(PCMSK0 & _BV(PCINT0)) && !SI4702_Signalled());
+}
+#endif
+
+static void Test_Errors()
+{
+  uint8_t data[2];
+  
+  Check("Absent slave is not acked", Read_I2C_Regs(0xa0, 0, 2, data) == I2C_NACK_ADDR);
+#ifdef I2C_TELEMETRY
+  struct I2C_Stats stats;
+  struct I2C_Record record = LastRecord();
+  Check("Telemetry: NACK recorded", record.addr == 0xa0 && record.amount == 0 && record.status == I2C_NACK_ADDR);
+  Check("Telemetry: no stats without a free slot", !I2C_GetStats(0xa0, &stats));
+  I2C_ClearStats();
+#endif
+  
+  uint64_t start = HostClock_ns;
+  
+  HostTWI_Stuck = 1;
+  Check("Stuck bus times out", Read_I2C_Raw(SI4702_ADDR, 2, data) == I2C_TIMEOUT);
+  HostTWI_Stuck = 0;
+  Check("Stuck bus costs milliseconds", HostClock_ns - start < 10000000ULL);
+#ifdef I2C_TELEMETRY
+  stats = Stats(SI4702_ADDR);
+  record = LastRecord();
+  Check("Telemetry: timeouts counted", stats.transactions == 1 && stats.errors == 1 && stats.timeouts == 2 && stats.recoveries == 2);
+  Check("Telemetry: timeout recorded", record.addr == SI4702_ADDR && record.status == I2C_TIMEOUT);
+#endif
+  
+  Check("Bus usable after a timeout", Read_I2C_Regs(0xd0, 8, 2, data) == I2C_OK);
+  
+  // A slave holding SDA low is clocked free, after which the transfer is retried
+  HostTWI_SDAHeld = 5;
+  Check("Held SDA recovered", Read_I2C_Regs(0xd0, 8, 2, data) == I2C_OK);
+  Check("Recovery status", I2C_GetRecoveryStatus() == I2C_RECOVERY_OK && HostTWI_SDAHeld == 0);
+#ifdef I2C_TELEMETRY
+  stats = Stats(0xd0);
+  Check("Telemetry: recovery counted", stats.transactions == 2 && stats.errors == 0 && stats.recoveries == 1);
+#endif
+  
+  start = HostClock_ns;
+  HostTWI_SDAHeld = 1000;
+  Check("Unrecoverable bus reported", Read_I2C_Regs(0xd0, 8, 2, data) == I2C_BUS_ERROR);
+  Check("Recovery failure status", I2C_GetRecoveryStatus() == I2C_RECOVERY_FAILED);
+  Check("Recovery gives up within milliseconds", HostClock_ns - start < 20000000ULL);
+  HostTWI_SDAHeld = 0;
+  
+  Check("Bus usable after failed recovery", Read_I2C_Regs(0xd0, 8, 2, data) == I2C_OK);
+  
+#ifdef I2C_TELEMETRY
+  // A background transaction stalled for longer than timer 2 wraps (16 ms),
+  // until I2C_Tick() catches it
+  struct I2C_Transaction t = { 0xd0, 8, I2C_READ, 2, { data }, 0, I2C_IDLE, 0 };
+  HostTWI_Stuck = 1;
+  I2C_Submit(&t);
+  for (uint8_t tick = 0; tick < 3 && t.status == I2C_PENDING; ++tick)
+  {
+    HostClock_Advance(49000);
+    I2C_Tick();
+  }
+  HostTWI_Stuck = 0;
+  I2C_Wait(&t);
+  record = LastRecord();
+  Check("Telemetry: stalled transaction saturates", record.addr == 0xd0 && record.ticks == 255);
+#endif
+}
+
+int main()
+{
+  HostTWI_Reset();
+  HostTWI_Attach(&HostDS1307);
+  HostTWI_Attach(&HostSI4702);
+  HostSI4702_Reset();
+  
+  Init_I2C();
+  
+  Test_DS1307();
+  Test_Clock();
+  Test_Settings();
+#ifndef SI4702_STC_IRQ
+  Test_SI4702();
+  Test_RDS();
+  Test_Throughput();
+#else
+  Test_Signal();
+#endif
+  Test_Errors();
+  
+  if (errorOccurred)
+    fprintf(stderr, "Test done, with errors\n");
+  else
+    printf("I2C tests passed\n");
+  
+  return errorOccurred;
+}
@@ -0,0 +1,172 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+// Runs the renderer through an hour of simulated clock time, driven like 
+// main.c drives it, and reports the SPI traffic and the render cost.
+#include <stdio.h>
+#include <time.h>
+#include "Renderer.h"
+#include "HostPanels.h"
+#include "DateTime.h"
+#include "settings.h"
+#include "BCDFuncs.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#define CYCLE_UNIT "host cycles"
+#else
+static inline uint64_t __ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#define CYCLES() __ns()
+#define CYCLE_UNIT "ns"
+#endif
+
+#define SIMULATED_SECONDS 3600
+#define CLOCK_TICK_MS 48
+
+struct Cost
+{
+  uint32_t calls;
+  uint64_t total, max;
+};
+
+static void __account(struct Cost *cost, const uint64_t start)
+{
+  uint64_t spent = CYCLES() - start;
+  
+  cost->calls++;
+  cost->total += spent;
+  
+  if (spent > cost->max)
+    cost->max = spent;
+}
+
+static void __advanceSecond()
+{
+  TheDateTime.sec = BCDAdd(TheDateTime.sec, 1);
+  
+  if (TheDateTime.sec < 0x60)
+    return;
+  
+  TheDateTime.sec = 0;
+  TheDateTime.min = BCDAdd(TheDateTime.min, 1);
+  
+  if (TheDateTime.min < 0x60)
+    return;
+  
+  TheDateTime.min = 0;
+  TheDateTime.hour = BCDAdd(TheDateTime.hour, 1);
+  
+  if (TheDateTime.hour >= 0x24)
+    TheDateTime.hour = 0;
+}
+
+static void RunScenario(const char *name, const uint8_t transition, const uint8_t ledState)
+{
+  struct Cost tickCost = { 0 }, renderCost = { 0 };
+  
+  TheDateTime.hour = 0x23;
+  TheDateTime.min = 0x30;
+  TheDateTime.sec = 0;
+  
+  InitializePanels();
+  Renderer_Init();
+  Renderer_SetTransition(transition);
+  Renderer_SetLed(LED_ON, ledState, LED_OFF, LED_OFF);
+  Renderer_Update_Main(MAIN_MODE_TIME, 0);
+  Renderer_Render(SECONDARY_MODE_SEC);
+  HostPanels_Reset();
+  
+  // Time in microseconds of the next event of each kind
+  uint64_t now = 0, nextSecond = 1000000, nextClockTick = CLOCK_TICK_MS * 1000, nextFrame = 0;
+  const uint64_t end = (uint64_t) SIMULATED_SECONDS * 1000000;
+  uint32_t wakeups = 0;
+  
+  while (now < end)
+  {
+    // Render clock only runs while animating
+    _Bool animating = Renderer_IsAnimating();
+    
+    if (!animating)
+      nextFrame = end;
+    
+    now = nextSecond;
+    if (nextClockTick < now)
+      now = nextClockTick;
+    if (nextFrame < now)
+      now = nextFrame;
+    
+    ++wakeups;
+    
+    const _Bool frameDue = (now == nextFrame), second = (now == nextSecond), clockTick = (now == nextClockTick);
+    
+    if (second)
+    {
+      __advanceSecond();
+      Renderer_Update_Main(MAIN_MODE_TIME, 1);
+      nextSecond += 1000000;
+    }
+    
+    if (clockTick)
+      nextClockTick += CLOCK_TICK_MS * 1000;
+    
+    // Same as the main loop
+    if (frameDue)
+    {
+      uint64_t start = CYCLES();
+      Renderer_Tick(SECONDARY_MODE_SEC);
+      __account(&tickCost, start);
+      nextFrame += 1000000 / RENDERER_FPS;
+    }
+    else
+    {
+      uint64_t start = CYCLES();
+      Renderer_Render(SECONDARY_MODE_SEC);
+      __account(&renderCost, start);
+    }
+    
+    if (!animating && Renderer_IsAnimating())
+      nextFrame = now + 1000000 / RENDERER_FPS; // Render clock started
+  }
+  
+  printf("%s:\n", name);
+  printf("  SPI: %u rows, %.1f bytes per second\n", (unsigned) HostPanels_Rows, (double) HostPanels_Bytes / SIMULATED_SECONDS);
+  printf("  Renderer_Tick: %u frames, %.0f %s per frame on average, %u max\n", (unsigned) tickCost.calls, 
+         tickCost.calls ? (double) tickCost.total / tickCost.calls : 0.0, CYCLE_UNIT, (unsigned) tickCost.max);
+  printf("  Renderer_Render: %u calls, %.0f %s on average, %u max\n", (unsigned) renderCost.calls, 
+         renderCost.calls ? (double) renderCost.total / renderCost.calls : 0.0, CYCLE_UNIT, (unsigned) renderCost.max);
+  printf("  Wakeups: %.2f per second, of which %.2f render clock frames\n", (double) wakeups / SIMULATED_SECONDS, (double) tickCost.calls / SIMULATED_SECONDS);
+}
+
+int main()
+{
+  TheDateTime.wday = 6;
+  TheDateTime.day = 0x17;
+  TheDateTime.month = 0x10;
+  TheDateTime.year = 0x26;
+  
+  printf("%d s of clock time, %d panels, %d fps\n\n", SIMULATED_SECONDS, PANEL_COUNT, RENDERER_FPS);
+  
+  RunScenario("Time and seconds, scroll", TRANSITION_SCROLL, LED_OFF);
+  RunScenario("Time and seconds, dissolve", TRANSITION_DISSOLVE, LED_OFF);
+  RunScenario("Time and seconds, scroll, blinking LED", TRANSITION_SCROLL, LED_BLINK_SHORT);
+  
+  return 0;
+}
@@ -0,0 +1,219 @@
+/*
+Copyright 2018, Martijn van Buul <martijn.van.buul@gmail.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+// Renders every main and secondary mode on the host and prints the captured
+// panel contents, to be compared against golden_frames.txt. Also checks that
+// the frame built up from the partial updates matches a full redraw.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Renderer.h"
+#include "HostPanels.h"
+#include "DateTime.h"
+#include "settings.h"
+#include "SI4702.h"
+
+extern uint8_t HostStubs_Volume;
+extern enum SI4702_State HostStubs_RadioState;
+
+static _Bool errorOccurred = 0;
+
+static struct AlarmSetting radioAlarm = { 0x07, 0x30, ALARM_ACTIVE | ALARM_TYPE_RADIO | ALARM_DAY_WEEK };
+static struct AlarmSetting beepAlarm = { 0x09, 0x15, ALARM_ACTIVE | ALARM_DAY_WEEKEND };
+static struct AlarmSetting suspendedAlarm = { 0x06, 0x45, ALARM_ACTIVE | ALARM_SUSPENDED | ALARM_DAY_DAILY };
+
+struct RenderCase
+{
+  const char *name;
+  uint8_t mainMode;
+  uint8_t secondaryMode;
+  const struct AlarmSetting *alarm;
+  uint16_t flashMask;
+  uint8_t inverted;
+  uint8_t leds[4];
+};
+
+static const struct RenderCase cases[] =
+{
+  { "time, seconds",           MAIN_MODE_TIME,  SECONDARY_MODE_SEC,         0,               0,     0, { LED_OFF, LED_OFF, LED_OFF, LED_OFF } },
+  { "date, year",              MAIN_MODE_DATE,  SECONDARY_MODE_YEAR,        0,               0,     0, { LED_OFF, LED_OFF, LED_OFF, LED_OFF } },
+  { "time, radio",             MAIN_MODE_TIME,  SECONDARY_MODE_RADIO,       0,               0,     0, { LED_ON, LED_OFF, LED_OFF, LED_OFF } },
+  { "time, volume",            MAIN_MODE_TIME,  SECONDARY_MODE_VOLUME,      0,               0,     0, { LED_OFF, LED_ON, LED_OFF, LED_OFF } },
+  { "alarm, radio alarm",      MAIN_MODE_ALARM, SECONDARY_MODE_ALARM,       &radioAlarm,     0,     0, { LED_OFF, LED_OFF, LED_ON, LED_OFF } },
+  { "alarm, beep alarm",       MAIN_MODE_ALARM, SECONDARY_MODE_ALARM,       &beepAlarm,      0,     0, { LED_OFF, LED_OFF, LED_OFF, LED_ON } },
+  { "alarm, suspended",        MAIN_MODE_ALARM, SECONDARY_MODE_ALARM,       &suspendedAlarm, 0,     0, { LED_ON, LED_ON, LED_ON, LED_ON } },
+  { "alarm, none",             MAIN_MODE_ALARM, SECONDARY_MODE_ALARM,       0,               0,     0, { LED_OFF, LED_OFF, LED_OFF, LED_OFF } },
+  { "sleep",                   MAIN_MODE_SLEEP, SECONDARY_MODE_SLEEP,       0,               0,     0, { LED_ON, LED_OFF, LED_OFF, LED_OFF } },
+  { "nap",                     MAIN_MODE_NAP,   SECONDARY_MODE_NAP,         0,               0,     0, { LED_ON, LED_OFF, LED_OFF, LED_OFF } },
+  { "date, time adjust",       MAIN_MODE_DATE,  SECONDARY_MODE_TIME_ADJUST, 0,               0,     0, { LED_OFF, LED_OFF, LED_OFF, LED_OFF } },
+  { "time, inverted",          MAIN_MODE_TIME,  SECONDARY_MODE_SEC,         0,               0,     1, { LED_OFF, LED_OFF, LED_OFF, LED_OFF } },
+  { "edit hours, flashing",    MAIN_MODE_TIME,  SECONDARY_MODE_SEC,         0,               0xc0,  0, { LED_OFF, LED_OFF, LED_OFF, LED_OFF } },
+  { "edit year, flashing",     MAIN_MODE_DATE,  SECONDARY_MODE_YEAR,        0,               0x03,  0, { LED_OFF, LED_OFF, LED_OFF, LED_OFF } },
+  { "edit alarm days, flashing", MAIN_MODE_ALARM, SECONDARY_MODE_ALARM,     &radioAlarm,     0x100, 0, { LED_BLINK_SHORT, LED_OFF, LED_OFF, LED_OFF } },
+  { 0 }
+};
+
+static void PrintFrame(const char *title)
+{
+  printf("== %s (brightness %d/16)\n", title, HostPanels_Fade);
+  
+  for (uint8_t row = 0; row < PANEL_ROWS; ++row)
+  {
+    for (uint8_t panel = 0; panel < PANEL_COUNT; ++panel)
+    {
+      uint8_t data = HostPanels_Frame[row * PANEL_COUNT + panel];
+      
+      for (uint8_t bit = 0; bit < 8; ++bit, data >>= 1)
+        putchar(data & 1 ? 'X' : '.');
+      
+      putchar(panel == PANEL_COUNT - 1 ? '\n' : ' ');
+    }
+  }
+}
+
+// The frame as built up from partial updates must equal a full redraw
+static void CheckAgainstRedraw(const char *title, const uint8_t secondaryMode)
+{
+  uint8_t incremental[FRAME_SIZE];
+  memcpy(incremental, HostPanels_Frame, sizeof(incremental));
+  
+  HostPanels_Reset();
+  Renderer_Redraw();
+  Renderer_Render(secondaryMode);
+  
+  if (memcmp(incremental, HostPanels_Frame, sizeof(incremental)))
+  {
+    fprintf(stderr, "%s: incremental update differs from full redraw\n", title);
+    errorOccurred = 1;
+  }
+}
+
+static void SetTime(const uint8_t hour, const uint8_t min)
+{
+  TheDateTime.hour = hour;
+  TheDateTime.min = min;
+}
+
+static void Test_Modes()
+{
+  for (const struct RenderCase *c = cases; c->name; ++c)
+  {
+    Renderer_SetAlarmStruct(c->alarm);
+    Renderer_SetFlashMask(c->flashMask);
+    Renderer_SetInverted(c->inverted ? INVERTED : NOT_INVERTED);
+    Renderer_SetLed(c->leds[0], c->leds[1], c->leds[2], c->leds[3]);
+    Renderer_Update_Main(c->mainMode, 0);
+    Renderer_Render(c->secondaryMode);
+    
+    PrintFrame(c->name);
+    CheckAgainstRedraw(c->name, c->secondaryMode);
+  }
+  
+  Renderer_SetFlashMask(0);
+  Renderer_SetLed(LED_OFF, LED_OFF, LED_OFF, LED_OFF);
+}
+
+// The frequency is replaced by dashes while the radio starts
+static void Test_RadioStarting()
+{
+  HostStubs_RadioState = SI4702_STARTING;
+  Renderer_Update_Main(MAIN_MODE_TIME, 0);
+  Renderer_Update_Secondary();
+  Renderer_Render(SECONDARY_MODE_RADIO);
+  
+  PrintFrame("time, radio starting");
+  CheckAgainstRedraw("time, radio starting", SECONDARY_MODE_RADIO);
+  HostStubs_RadioState = SI4702_ON;
+}
+
+static void Test_Transitions()
+{
+  static const char *names[] = { "scroll", "wipe", "dissolve", "fade" };
+  static const uint16_t durations[] = { 400, 500, 480, 600 }; // ms. The wipe staggers its digits.
+  
+  for (uint8_t transition = TRANSITION_SCROLL; transition <= TRANSITION_FADE; ++transition)
+  {
+    char title[64];
+    
+    Renderer_SetTransition(transition);
+    SetTime(0x12, 0x59);
+    Renderer_Update_Main(MAIN_MODE_TIME, 0);
+    Renderer_Render(SECONDARY_MODE_SEC);
+    
+    SetTime(0x13, 0x00);
+    Renderer_Update_Main(MAIN_MODE_TIME, 1);
+    Renderer_Render(SECONDARY_MODE_SEC);
+    
+    int frame;
+    for (frame = 1; Renderer_IsAnimating(); ++frame)
+    {
+      Renderer_Tick(SECONDARY_MODE_SEC);
+      
+      if (frame % 4 == 0 || !Renderer_IsAnimating() || HostPanels_Fade == 0) // Also the darkest frames
+      {
+        snprintf(title, sizeof(title), "%s, frame %d", names[transition], frame);
+        PrintFrame(title);
+      }
+      
+      if (frame > 10 * RENDERER_FPS)
+      {
+        fprintf(stderr, "%s: transition does not end\n", names[transition]);
+        errorOccurred = 1;
+        break;
+      }
+    }
+    
+    // Within 10%, give or take a frame
+    int ms = (frame - 1) * 1000 / RENDERER_FPS;
+    if (abs(ms - durations[transition]) > durations[transition] / 10 + 1000 / RENDERER_FPS)
+    {
+      fprintf(stderr, "%s: took %d ms, expected %d\n", names[transition], ms, durations[transition]);
+      errorOccurred = 1;
+    }
+    
+    CheckAgainstRedraw(names[transition], SECONDARY_MODE_SEC);
+  }
+  
+  Renderer_SetTransition(TRANSITION_SCROLL);
+}
+
+int main()
+{
+  TheDateTime.sec = 0x56;
+  TheDateTime.min = 0x34;
+  TheDateTime.hour = 0x12;
+  TheDateTime.wday = 6;
+  TheDateTime.day = 0x17;
+  TheDateTime.month = 0x10;
+  TheDateTime.year = 0x26;
+  
+  TheSleepTime = 15;
+  TheNapTime = 75;
+  HostStubs_Volume = 7;
+  TheGlobalSettings.radio.frequency = 1017;
+  TheGlobalSettings.time_adjust = -12;
+  
+  InitializePanels();
+  Renderer_Init();
+  
+  Test_Modes();
+  Test_RadioStarting();
+  Test_Transitions();
+  
+  if (errorOccurred)
+    fprintf(stderr, "Test done, with errors\n");
+  
+  return errorOccurred;
+}
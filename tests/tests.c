@@ -22,6 +22,7 @@ PERFORMANCE OF THIS SOFTWARE.
 #include "../DateTime.h"
 #include "../BCDFuncs.h"
 #include "../settings.h"
+#include "../RDS.h"
 #include <avr/pgmspace.h>
 
 AVR_MCU(F_CPU, "atmega168p");
@@ -226,6 +227,35 @@ static void Test_BCDToBin()
   }
 }
 
+static void Test_BinToBCD()
+{
+  static const char PROGMEM title []= "BinToBCD..\n";
+  printf_P(title);
+    
+  for (int testIdx = 0;; ++testIdx)
+  {
+    const uint8_t expect = pgm_read_byte(2 * testIdx + BCDToBin_tests + 0),
+                  input = pgm_read_byte(2 * testIdx + BCDToBin_tests + 1);
+                  
+    if (expect == 0)
+      break;
+      
+    const uint8_t actual = BinToBCD(input);
+    
+    if (actual != expect)
+    {
+      static const char PROGMEM fmt[]="%d: Expected 0x%02x, got 0x%02x\n";
+      printf_P(fmt, input, expect, actual);
+      errorOccurred = 1;
+    }
+    else 
+    { 
+      static const char PROGMEM fmt[]="%d: OK (0x%02x)\n";
+      printf_P(fmt, input, actual);
+    }
+  }
+}
+
 const uint8_t PROGMEM BCDAdd_tests[] =  {
     // left, right, expected
     0x00, 0x12, 0x12,
@@ -541,6 +571,16 @@ const uint8_t PROGMEM IDA_tests[] =
   0x18, 0x10, 0x28, 0x00, 1, 1, // October on transation date but before time
   0x18, 0x10, 0x28, 0x02, 0, 0, // October on transation date but after time 
   0x18, 0x10, 0x28, 0x01, 1, 0, // October on transation date but after time 
+  0x18, 0x10, 0x28, 0x01, 0, 1, // October, 01:12 local is CEST
+  0x18, 0x10, 0x28, 0x02, 0, 0, // October, 02:12 local occurs twice; assumed to be CET
+  0x18, 0x10, 0x28, 0x03, 0, 0, // October, 03:12 local is CET
+  0x19, 0x03, 0x31, 0x00, 1, 0, // Next year: March on transition date but before time
+  0x19, 0x03, 0x31, 0x01, 1, 1, // Next year: March on transition date but after time
+  0x19, 0x03, 0x31, 0x01, 0, 0, // Next year: 01:12 local is CET
+  0x19, 0x03, 0x31, 0x02, 0, 1, // Next year: 02:12 local does not exist, taken as CEST
+  0x18, 0x10, 0x28, 0x00, 1, 1, // Back to the previous year
+  0x00, 0x01, 0x01, 0x00, 0, 0, // First hour of 2000 local, before the start of the epoch in UTC
+  0x00, 0x07, 0x01, 0x12, 0, 1, // Summer of 2000
   
   0xff
 };
@@ -590,6 +630,148 @@ static void Test_IsDSTActive()
   }
 }
 
+struct EpochTest
+{
+  uint8_t year, month, day, hour, min, sec, wday;
+  uint32_t epoch;
+};
+
+const struct EpochTest PROGMEM Epoch_tests[] =
+{
+  { 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 6, 0 },
+  { 0x00, 0x02, 0x29, 0x12, 0x34, 0x56, 2, 5142896 }, // Leap day
+  { 0x00, 0x03, 0x01, 0x00, 0x00, 0x00, 3, 5184000 },
+  { 0x00, 0x12, 0x31, 0x23, 0x59, 0x59, 7, 31622399 }, // End of a leap year
+  { 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 1, 31622400 },
+  { 0x18, 0x10, 0x28, 0x01, 0x00, 0x00, 7, 594003600 },
+  { 0x19, 0x03, 0x31, 0x01, 0x00, 0x00, 7, 607309200 },
+  { 0x24, 0x02, 0x29, 0x07, 0x15, 0x00, 4, 762506100 },
+  { 0x99, 0x12, 0x31, 0x23, 0x59, 0x59, 4, 3155759999 },
+  { 0xff }
+};
+
+static void Test_Epoch()
+{
+  static const char PROGMEM title []= "Epoch..\n";
+  printf_P(title);
+  
+  for( int testIdx = 0; ; ++testIdx)
+  {
+    struct EpochTest test;
+    memcpy_P(&test, Epoch_tests + testIdx, sizeof(test));
+    if (test.year == 0xff)
+      break;
+    
+    struct DateTime expectedTime = { test.sec, test.min, test.hour, test.wday, test.day, test.month, test.year };
+    struct DateTime actualTime;
+    
+    EpochToDateTime(test.epoch, &actualTime);
+    const uint32_t actual = DateTimeToEpoch(&expectedTime);
+    
+    printTime(&expectedTime);
+    
+    if (actual == test.epoch && timesAreEqual(&actualTime, &expectedTime) && actualTime.wday == test.wday)
+    {
+      static const char PROGMEM fmt[]=" OK (%" PRIu32 ")\n";
+      printf_P(fmt, actual);
+    }
+    else
+    {
+      static const char PROGMEM fmt[]=": Expected %" PRIu32 ", got %" PRIu32 " (";
+      printf_P(fmt, test.epoch, actual);
+      printTime(&actualTime);
+      static const char PROGMEM fmt2[]=" wday %d)\n";
+      printf_P(fmt2, actualTime.wday);
+      errorOccurred = 1;
+    }
+  }
+}
+
+const uint8_t PROGMEM CET_tests[] =
+{
+  // UTC Year, Month, Day, Hour, Min -> CET Year, Month, Day, Hour, Min
+  0x19, 0x01, 0x15, 0x10, 0x20  , 0x19, 0x01, 0x15, 0x11, 0x20, // Winter time
+  0x19, 0x07, 0x15, 0x10, 0x20  , 0x19, 0x07, 0x15, 0x12, 0x20, // Summer time
+  0x19, 0x03, 0x31, 0x00, 0x59  , 0x19, 0x03, 0x31, 0x01, 0x59, // Just before the switch to summer time
+  0x19, 0x03, 0x31, 0x01, 0x00  , 0x19, 0x03, 0x31, 0x03, 0x00, // Switch to summer time
+  0x18, 0x10, 0x28, 0x00, 0x59  , 0x18, 0x10, 0x28, 0x02, 0x59, // Just before the switch to winter time
+  0x18, 0x10, 0x28, 0x01, 0x00  , 0x18, 0x10, 0x28, 0x02, 0x00, // Switch to winter time
+  0x18, 0x12, 0x31, 0x23, 0x30  , 0x19, 0x01, 0x01, 0x00, 0x30, // Year rollover
+  0xff
+};
+
+const uint8_t PROGMEM UTC_tests[] =
+{
+  // CET Year, Month, Day, Hour, Min -> UTC Year, Month, Day, Hour, Min
+  0x18, 0x10, 0x28, 0x01, 0x30  , 0x18, 0x10, 0x27, 0x23, 0x30, // CEST
+  0x18, 0x10, 0x28, 0x02, 0x30  , 0x18, 0x10, 0x28, 0x01, 0x30, // Occurs twice, taken as CET
+  0x18, 0x10, 0x28, 0x03, 0x30  , 0x18, 0x10, 0x28, 0x02, 0x30, // CET
+  0x19, 0x03, 0x31, 0x01, 0x30  , 0x19, 0x03, 0x31, 0x00, 0x30, // CET
+  0x19, 0x03, 0x31, 0x03, 0x30  , 0x19, 0x03, 0x31, 0x01, 0x30, // CEST
+  0x19, 0x01, 0x01, 0x00, 0x30  , 0x18, 0x12, 0x31, 0x23, 0x30, // Year rollover
+  0xff
+};
+
+static void Test_Conversion(const uint8_t *tests, void (*convert)(struct DateTime *))
+{
+  struct DateTime testTime;
+  struct DateTime expectedTime;
+  
+  testTime.sec = 0x45;
+  expectedTime.sec = 0x45;
+  
+  for( int testIdx = 0; ; ++testIdx)
+  {
+    testTime.year = pgm_read_byte( 10 * testIdx + tests + 0);
+    if (testTime.year == 0xff)
+      break;
+    testTime.month = pgm_read_byte( 10 * testIdx + tests + 1);
+    testTime.day = pgm_read_byte( 10 * testIdx + tests + 2);
+    testTime.hour = pgm_read_byte( 10 * testIdx + tests + 3);
+    testTime.min = pgm_read_byte( 10 * testIdx + tests + 4);
+    
+    expectedTime.year = pgm_read_byte( 10 * testIdx + tests + 5);
+    expectedTime.month = pgm_read_byte( 10 * testIdx + tests + 6);
+    expectedTime.day = pgm_read_byte( 10 * testIdx + tests + 7);
+    expectedTime.hour = pgm_read_byte( 10 * testIdx + tests + 8);
+    expectedTime.min = pgm_read_byte( 10 * testIdx + tests + 9);
+    
+    printTime(&testTime);
+    
+    convert(&testTime);
+    if (timesAreEqual(&testTime, &expectedTime))
+    {
+      static const char PROGMEM fmt[]=" OK\n";
+      printf_P(fmt);
+    }
+    else
+    {
+      static const char PROGMEM fmt[]=": Expected ";
+      printf_P(fmt);
+      printTime(&expectedTime);
+      static const char PROGMEM fmt2[]=" Got ";
+      printf_P(fmt2);
+      printTime(&testTime);
+      uart_putchar('\n', stdout);
+      errorOccurred =1;
+    }
+  }
+}
+
+static void Test_UTCToCentralEuropeanTime()
+{
+  static const char PROGMEM title []= "UTCToCentralEuropeanTime..\n";
+  printf_P(title);
+  Test_Conversion(CET_tests, UTCToCentralEuropeanTime);
+}
+
+static void Test_CentralEuropeanTimeToUTC()
+{
+  static const char PROGMEM title []= "CentralEuropeanTimeToUTC..\n";
+  printf_P(title);
+  Test_Conversion(UTC_tests, CentralEuropeanTimeToUTC);
+}
+
 const uint8_t PROGMEM IIDO_tests[] = 
 {
   // Month, hour, expected
@@ -894,11 +1076,145 @@ void Test_DecreaseBrightness()
   }
 }
 
+struct RDSGroup
+{
+  uint16_t blocks[4]; // A - D
+  uint8_t errors[4];  // 0 = none, 3 = uncorrectable
+};
+
+#define RDS_PI 0x8201
+
+const struct RDSGroup PROGMEM RDS_PS_groups[] = 
+{
+  { { RDS_PI, 0x0000, 0xe0cd, 0x5241 }, { 0, 0, 0, 0 } }, // 0A "RA"
+  { { RDS_PI, 0x0001, 0xe0cd, 0x5858 }, { 0, 0, 0, 3 } }, // 0A "XX", uncorrectable
+  { { RDS_PI, 0x0002, 0xe0cd, 0x4f20 }, { 0, 0, 0, 1 } }, // 0A "O ", corrected
+  { { 0x1234, 0x0803, RDS_PI, 0x3120 }, { 3, 0, 0, 0 } }, // 0B "1 ", PI unreliable
+  { { RDS_PI, 0x0001, 0xe0cd, 0x4449 }, { 0, 2, 0, 0 } }, // 0A "DI", group type unreliable
+  { { RDS_PI, 0x0001, 0xe0cd, 0x4449 }, { 0, 0, 0, 0 } }, // 0A "DI"
+};
+
+const struct RDSGroup PROGMEM RDS_RT_groups[] = 
+{
+  { { RDS_PI, 0x2000, 0x4865, 0x6c6c }, { 0, 0, 0, 0 } }, // 2A "Hell"
+  { { RDS_PI, 0x2001, 0x6f20, 0x3f0d }, { 0, 0, 1, 0 } }, // 2A "o ?", end
+  { { RDS_PI, 0x2010, 0x4279, 0x650d }, { 0, 0, 0, 0 } }, // 2A "Bye", new text
+  { { RDS_PI, 0x2010, 0x476f, 0x6f64 }, { 0, 0, 0, 0 } }, // 2A "Good", longer text without A/B toggle
+  { { RDS_PI, 0x2011, 0x6279, 0x650d }, { 0, 0, 0, 0 } }, // 2A "bye", end
+  { { RDS_PI, 0x2000, 0x4869, 0x0d20 }, { 0, 0, 0, 0 } }, // 2A "Hi", new text
+  { { RDS_PI, 0x2002, 0x210d, 0x2020 }, { 0, 0, 0, 0 } }, // 2A "!", end of a longer text without A/B toggle
+  { { RDS_PI, 0x2001, 0x6865, 0x7265 }, { 0, 0, 0, 0 } }, // 2A "here"
+  { { RDS_PI, 0x2000, 0x4869, 0x2074 }, { 0, 0, 0, 0 } }, // 2A "Hi t"
+};
+
+const struct RDSGroup PROGMEM RDS_other_groups[] = 
+{
+  { { RDS_PI, 0x4001, 0xc99a, 0x1002 }, { 0, 0, 0, 0 } }, // 4A 2019-03-31 01:00 UTC, +01:00
+  { { RDS_PI + 1, 0x0000, 0xe0cd, 0x5241 }, { 0, 0, 0, 0 } }, // Another station
+};
+
+static void DecodeRDS(const struct RDSGroup *groups, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; ++i)
+  {
+    struct RDSGroup group;
+    memcpy_P(&group, groups + i, sizeof(group));
+    RDS_Decode(group.blocks, group.errors);
+  }
+}
+
+static void CheckRDS(const char *name, const char *actual, const char *expected)
+{
+  printf_P(name);
+  
+  if (actual == expected || (actual && expected && !strcmp_P(actual, expected)))
+  {
+    static const char PROGMEM fmt[]=": OK\n";
+    printf_P(fmt);
+  }
+  else
+  {
+    static const char PROGMEM fmt[]=": got '%s'\n";
+    printf_P(fmt, actual ? actual : "(none)");
+    errorOccurred = 1;
+  }
+}
+
+static void Test_RDS()
+{
+  static const char PROGMEM title []= "RDS..\n";
+  printf_P(title);
+  
+  RDS_Reset();
+  
+  static const char PROGMEM psIncomplete[] = "Station name, incomplete";
+  DecodeRDS(RDS_PS_groups, 5);
+  CheckRDS(psIncomplete, RDS_GetStationName(), 0);
+  
+  static const char PROGMEM ps[] = "Station name";
+  static const char PROGMEM psExpected[] = "RADIO 1 ";
+  DecodeRDS(RDS_PS_groups + 5, 1);
+  CheckRDS(ps, RDS_GetStationName(), psExpected);
+  
+  static const char PROGMEM rtIncomplete[] = "RadioText, incomplete";
+  DecodeRDS(RDS_RT_groups, 1);
+  CheckRDS(rtIncomplete, RDS_GetRadioText(), 0);
+  
+  static const char PROGMEM rt[] = "RadioText";
+  static const char PROGMEM rtExpected[] = "Hello ?";
+  DecodeRDS(RDS_RT_groups + 1, 1);
+  CheckRDS(rt, RDS_GetRadioText(), rtExpected);
+  
+  static const char PROGMEM rtNew[] = "RadioText, A/B toggled";
+  static const char PROGMEM rtNewExpected[] = "Bye";
+  DecodeRDS(RDS_RT_groups + 2, 1);
+  CheckRDS(rtNew, RDS_GetRadioText(), rtNewExpected);
+  
+  static const char PROGMEM rtLonger[] = "RadioText, longer";
+  static const char PROGMEM rtLongerExpected[] = "Goodbye";
+  DecodeRDS(RDS_RT_groups + 3, 1);
+  CheckRDS(rtIncomplete, RDS_GetRadioText(), 0);
+  DecodeRDS(RDS_RT_groups + 4, 1);
+  CheckRDS(rtLonger, RDS_GetRadioText(), rtLongerExpected);
+  
+  // The segment with the old end marker must be received again
+  static const char PROGMEM rtShort[] = "RadioText, short";
+  static const char PROGMEM rtShortExpected[] = "Hi";
+  static const char PROGMEM rtMarker[] = "RadioText, end marker moved";
+  static const char PROGMEM rtMarkerExpected[] = "Hi there!";
+  DecodeRDS(RDS_RT_groups + 5, 1);
+  CheckRDS(rtShort, RDS_GetRadioText(), rtShortExpected);
+  DecodeRDS(RDS_RT_groups + 6, 2);
+  CheckRDS(rtIncomplete, RDS_GetRadioText(), 0);
+  DecodeRDS(RDS_RT_groups + 8, 1);
+  CheckRDS(rtMarker, RDS_GetRadioText(), rtMarkerExpected);
+  
+  uint32_t epoch = 0;
+  DecodeRDS(RDS_other_groups, 1);
+  _Bool received = RDS_TakeClockTime(&epoch);
+  if (received && epoch == 607309200 && !RDS_TakeClockTime(&epoch))
+  {
+    static const char PROGMEM fmt[]="Clock time: OK\n";
+    printf_P(fmt);
+  }
+  else
+  {
+    static const char PROGMEM fmt[]="Clock time: got %d, %" PRIu32 "\n";
+    printf_P(fmt, received, epoch);
+    errorOccurred = 1;
+  }
+  
+  static const char PROGMEM psOther[] = "Station name, other station";
+  DecodeRDS(RDS_other_groups + 1, 1);
+  CheckRDS(psOther, RDS_GetStationName(), 0);
+}
+
 int main()
 { 
   stdout = &mystdout;
 
   Test_BCDToBin();
+  Test_BinToBCD();
   Test_BCDAdd();
   Test_BCDSub();
   Test_HandleEditUp();
@@ -909,6 +1225,10 @@ int main()
   Test_GetDateOfLastSunday();
   Test_NormalizeHours();
   Test_IsDSTActive();
+  Test_Epoch();
+  Test_UTCToCentralEuropeanTime();
+  Test_CentralEuropeanTimeToUTC();
+  Test_RDS();
   Test_IsItDarkOutside();
   Test_GetActiveBrightness();
   Test_IncreaseBrightness();